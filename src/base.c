@@ -9,11 +9,13 @@
  */
 
 #include "base.h"
+#include "crc32c.h"
 #include "options.h"
 #include "search.h"
 #include "perft.h"
 
 #include <assert.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -21,6 +23,33 @@
 #include <string.h>
 #include <time.h>
 
+/** number of games processed at once by a thread, to make a base unique */
+#define BASE_UNIQUE_CHUNK 4096
+
+/** number of games held in memory at once, to check a base file */
+#define BASE_ANALYSIS_CHUNK 65536
+
+/** number of games processed at once by a thread, to index a base */
+#define BASE_INDEX_CHUNK 4096
+
+/** number of games whose positions are sorted in memory at once, to index a base */
+#define BASE_INDEX_RUN 16384
+
+/** number of games processed at once by a thread, to compare bases */
+#define BASE_COMPARE_CHUNK 1024
+
+/** number of shards of a position set (a power of 2) */
+#define POSITION_SET_SHARDS 1024
+
+/** size of the chunks of a text base file, parsed by a thread */
+#define BASE_TEXT_CHUNK (1 << 20)
+
+/** number of chunks of a text base file parsed at once, per thread */
+#define BASE_TEXT_BATCH 4
+
+/** tag of the base index file format */
+#define BIDX 0x42494458
+
 /**
  * @brief Set wthor header.
  *
@@ -414,7 +443,7 @@ bool base_to_wthor(const Base *base, WthorBase *wthor)
  * @param i game intex
  * @param f output stream.
  */
-void wthor_print_game(WthorBase *base, int i, FILE *f)
+void wthor_print_game(const WthorBase *base, int i, FILE *f)
 {
 	Game game;
 
@@ -478,9 +507,259 @@ int pv_check(const Board *init_board, Line *pv, Search *search)
 	return game_analyze(&game, search, board_count_empties(init_board), false);
 }
 
+/**
+ * @brief Get the position to solve from a Wthor game, with its theoretical score.
+ *
+ * @param base Wthor base.
+ * @param wthor Wthor game.
+ * @param board Position to solve (output).
+ * @param player Player to move (output).
+ * @param score Theoretical score (output).
+ * @param verbose Warn about the bad games.
+ * @return true if the game is valid.
+ */
+static bool wthor_get_problem(const WthorBase *base, WthorGame *wthor, Board *board, int *player, int *score, const bool verbose)
+{
+	int n_empties;
+
+	wthorgame_get_board(wthor, base->header.depth, board, player);
+	n_empties = board_count_empties(board);
+	if (n_empties != base->header.depth && !board_is_game_over(board)) {
+		if (verbose) {
+			warn("Incomplete or Illegal game: %d empties\n", n_empties);
+			wthor_print_game(base, wthor - base->game, stderr);
+		}
+		return false;
+	}
+
+	if (*player == WHITE) *score = 64 - 2 * wthor->theoric_score;
+	else *score = 2 * wthor->theoric_score - 64;
+	if (abs(*score) > 64) {
+		if (verbose) {
+			warn("Impossible theoric score:\n");
+			wthor_print_game(base, wthor - base->game, stderr);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Check the PV found by a search, and warn about its errors.
+ *
+ * @param board Position searched.
+ * @param player Player to move.
+ * @param search Search.
+ */
+static void wthor_check_pv(const Board *board, const int player, Search *search)
+{
+	Line pv;
+	char s[80];
+
+	line_copy(&pv, &search->result->pv, 0);
+	if (pv_check(board, &pv, search)) {
+		warn("Wrong pv:\n");
+		board_print(board, player, stderr);
+		fprintf(stderr, "setboard %s\nplay ", board_to_string(board, player, s));
+		line_print(&pv, 200, " ", stderr);
+		putc('\n', stderr); putc('\n', stderr);
+		assert(false); // stop here when debug is on
+	}
+}
+
+/**
+ * @brief Print the number of games solved per second.
+ *
+ * @param n_games Number of games.
+ * @param t Time (in ms).
+ */
+static void wthor_print_speed(const int n_games, const int64_t t)
+{
+	printf("%d games in ", n_games);
+	time_print(t, false, stdout);
+	if (t > 0) printf(" (%.2f games/s)", 1000.0 * n_games / t);
+	putchar('\n');
+}
+
+/** A position of a wthor game solved from a batch */
+typedef struct WthorProblem {
+	Board board;        /**<! position to solve */
+	int player;         /**<! player to move */
+	int score;          /**<! theoretical score */
+	int game;           /**<! game index */
+	Result result;      /**<! search result */
+	bool is_done;       /**<! position solved? */
+} WthorProblem;
+
+/** Positions of a wthor base solved simultaneously */
+typedef struct WthorBatch {
+	const WthorBase *base;       /**<! wthor base */
+	const char *file;            /**<! wthor file */
+	WthorProblem *problem;       /**<! positions to solve */
+	int n;                       /**<! number of positions */
+	_Atomic int i;               /**<! next position to solve */
+	int i_print;                 /**<! next position to report */
+	int level;                   /**<! search level */
+	int verbosity;               /**<! verbosity of the report */
+	uint64_t (*histogram)[65];   /**<! score histogram to fill (or NULL to check the scores) */
+	int n_failure;               /**<! number of wrong scores */
+	int64_t n_nodes;             /**<! node count */
+	int64_t t;                   /**<! starting time */
+	mtx_t mutex;                 /**<! lock */
+} WthorBatch;
+
+/** A search solving positions from a batch */
+typedef struct WthorWorker {
+	Search search;               /**<! search */
+	WthorBatch *batch;           /**<! batch */
+	thrd_t thread;               /**<! thread */
+} WthorWorker;
+
+/**
+ * @brief Report the result of a solved position, as wthor_test or wthor_eval does.
+ *
+ * @param batch Batch.
+ * @param problem Solved position.
+ */
+static void wthor_batch_report(WthorBatch *batch, WthorProblem *problem)
+{
+	if (batch->histogram) {
+		++batch->histogram[problem->result.score + 64][(problem->score + 64) / 2];
+		return;
+	}
+
+	batch->n_nodes += problem->result.n_nodes;
+	if (batch->verbosity == 1) {
+		result_print(&problem->result, stdout);
+		putchar('\n');
+	}
+	if (batch->verbosity) putchar('\n');
+	if (problem->score != problem->result.score) {
+		warn("Wrong theoric score: %+d (Wthor) instead of %+d (Edax)\n", problem->score, problem->result.score);
+		wthor_print_game(batch->base, problem->game, stderr);
+		++batch->n_failure;
+		assert(false); // stop here when debug is on
+	}
+	if (batch->verbosity == 0) {
+		printf("%s  game: %4d, error: %2d ; ", batch->file, problem->game + 1, batch->n_failure);
+		printf("%" PRIu64 " n, ", batch->n_nodes); time_print(real_clock() - batch->t, false, stdout); putchar('\r');
+		fflush(stdout);
+	}
+}
+
+/**
+ * @brief Solve positions from a batch, until none is left.
+ *
+ * Results are reported in the order of the games.
+ *
+ * @param v Worker (cast as void).
+ * @return thrd_success.
+ */
+static int wthor_batch_run(void *v)
+{
+	WthorWorker *worker = (WthorWorker*) v;
+	WthorBatch *batch = worker->batch;
+	Search *search = &worker->search;
+	WthorProblem *problem;
+	int i;
+
+	while ((i = atomic_fetch_add(&batch->i, 1)) < batch->n) {
+		problem = batch->problem + i;
+		search_cleanup(search);
+		search_set_board(search, &problem->board, problem->player);
+		search_set_level(search, batch->level, batch->base->header.depth);
+		search_run(search);
+		if (batch->histogram == NULL && options.pv_check) wthor_check_pv(&problem->board, problem->player, search);
+
+		mtx_lock(&batch->mutex);
+			problem->result = *search->result;
+			problem->result.n_nodes = search_count_nodes(search);
+			problem->is_done = true;
+			while (batch->i_print < batch->n && batch->problem[batch->i_print].is_done) {
+				wthor_batch_report(batch, batch->problem + batch->i_print++);
+			}
+		mtx_unlock(&batch->mutex);
+	}
+
+	return thrd_success;
+}
+
+/**
+ * @brief Solve the positions of a wthor base, several simultaneously.
+ *
+ * options.n_batch searches run in parallel, each one with its share of the
+ * tasks and of the hash table memory.
+ *
+ * @param file Wthor file.
+ * @param base Wthor base.
+ * @param search Search providing the report options.
+ * @param level Search level.
+ * @param histogram Score histogram to fill (or NULL to check the theoretical scores).
+ */
+static void wthor_batch(const char *file, WthorBase *base, const Search *search, const int level, uint64_t histogram[129][65])
+{
+	WthorBatch batch;
+	WthorWorker *worker;
+	WthorGame *wthor;
+	WthorProblem *problem;
+	const int n_batch = options.n_batch;
+	int i;
+
+	batch.problem = (WthorProblem*) malloc(base->n_games * sizeof (WthorProblem) + 1);
+	worker = (WthorWorker*) malloc(n_batch * sizeof (WthorWorker));
+	if (batch.problem == NULL || worker == NULL) fatal_error("wthor: cannot allocate the games to solve\n");
+
+	batch.n = 0;
+	foreach_wthorgame(wthor, *base) {
+		problem = batch.problem + batch.n;
+		if (wthor_get_problem(base, wthor, &problem->board, &problem->player, &problem->score, histogram == NULL)) {
+			problem->game = wthor - base->game;
+			problem->is_done = false;
+			++batch.n;
+		}
+	}
+	batch.base = base;
+	batch.file = file;
+	atomic_init(&batch.i, 0);
+	batch.i_print = 0;
+	batch.level = level;
+	batch.verbosity = search->options.verbosity;
+	batch.histogram = histogram;
+	batch.n_failure = 0;
+	batch.n_nodes = 0;
+	batch.t = real_clock();
+	mtx_init(&batch.mutex, mtx_plain);
+
+	for (i = 0; i < n_batch; ++i) {
+		search_init_shared(&worker[i].search, n_batch, i);
+		worker[i].search.options.verbosity = 0;
+		worker[i].batch = &batch;
+	}
+	info("<wthor: %d games solved by %d searches of %d tasks>\n", batch.n, n_batch, MAX(1, options.n_task / n_batch));
+	if (histogram == NULL && batch.verbosity == 1) {
+		if (search->options.header) puts(search->options.header);
+		if (search->options.separator) puts(search->options.separator);
+	}
+
+	for (i = 0; i < n_batch; ++i) thrd_create(&worker[i].thread, wthor_batch_run, worker + i);
+	for (i = 0; i < n_batch; ++i) thrd_join(worker[i].thread, NULL);
+
+	if (histogram == NULL && batch.verbosity == 1 && search->options.separator) puts(search->options.separator);
+	if (histogram == NULL) putchar('\n');
+	wthor_print_speed(batch.n, real_clock() - batch.t);
+
+	for (i = 0; i < n_batch; ++i) search_free(&worker[i].search);
+	mtx_destroy(&batch.mutex);
+	free(worker);
+	free(batch.problem);
+}
+
 /**
  * @brief Test Search with a wthor base.
  *
+ * With several -batch searches, the games are solved simultaneously.
+ *
  * @param file Game File.
  * @param search Search.
  */
@@ -491,45 +770,39 @@ void wthor_test(const char *file, Search *search)
 	Board board;
 	int player;
 	int score;
-	int n_empties;
+	int n_games;
 	int n_failure;
 	int64_t n_nodes;
-	int64_t t;
-	int n_err;
+	int64_t t, t_real;
 
 	if (wthor_load(&base, file)) {
 
+		if (options.n_batch > 1) {
+			wthor_batch(file, &base, search, 60, NULL);
+			wthor_free(&base);
+			return;
+		}
+
 		if (search->options.verbosity == 1) {
 			if (search->options.header) puts(search->options.header);
 			if (search->options.separator) puts(search->options.separator);
 		}
 
+		n_games = 0;
 		n_failure = 0;
 		n_nodes = 0;
 		t = 0;
+		t_real = -real_clock();
 
 		foreach_wthorgame(wthor, base) {
-			wthorgame_get_board(wthor, base.header.depth, &board, &player);
-			n_empties = board_count_empties(&board);
-			if (n_empties != base.header.depth && !board_is_game_over(&board)) {
-				warn("Incomplete or Illegal game: %d empties\n", n_empties);
-				wthor_print_game(&base, wthor - base.game, stderr);
-				continue;
-			}
-
-			if (player == WHITE) score = 64 - 2 * wthor->theoric_score;
-			else score = 2 * wthor->theoric_score - 64;
-			if (abs(score) > 64) {
-				warn("Impossible theoric score:\n");
-				wthor_print_game(&base, wthor - base.game, stderr);
-				continue;
-			}
+			if (!wthor_get_problem(&base, wthor, &board, &player, &score, true)) continue;
 
 			search_cleanup(search);
 			search_set_board(search, &board, player);
 			search_set_level(search, 60, base.header.depth);
 			search_run(search);
 			if (search->options.verbosity) putchar('\n');
+			++n_games;
 			n_nodes += search->result->n_nodes;
 			t += search->result->time;
 			if (score != search->result->score) {
@@ -539,20 +812,7 @@ void wthor_test(const char *file, Search *search)
 				assert(false); // stop here when debug is on
 			}
 
-			if (options.pv_check) {
-				Line pv;
-				line_copy(&pv, &search->result->pv, 0);
-				n_err = pv_check(&board, &pv, search);
-				if (n_err) {
-					char s[80];
-					warn("Wrong pv:\n");
-					board_print(&board, player, stderr);
-					fprintf(stderr, "setboard %s\nplay ", board_to_string(&board, player, s));
-					line_print(&pv, 200, " ", stderr);
-					putc('\n', stderr); putc('\n', stderr);
-					assert(false); // stop here when debug is on
-				}
-			}
+			if (options.pv_check) wthor_check_pv(&board, player, search);
 
 			if (search->options.verbosity == 0) {
 				printf("%s  game: %4d, error: %2d ; ", file, (int)(wthor - base.game) + 1, n_failure);
@@ -564,6 +824,7 @@ void wthor_test(const char *file, Search *search)
 			if (search->options.separator) puts(search->options.separator);
 		}
 		putchar('\n');
+		wthor_print_speed(n_games, t_real + real_clock());
 
 		wthor_free(&base);
 	}
@@ -574,6 +835,7 @@ void wthor_test(const char *file, Search *search)
  * @brief Test Eval with a wthor base.
  *
  * Given a wthor file, compare the result of a search to the theoretical scores.
+ * With several -batch searches, the games are searched simultaneously.
  *
  * @param file Game File.
  * @param search Search.
@@ -586,28 +848,27 @@ void wthor_eval(const char *file, Search *search, uint64_t histogram[129][65])
 	Board board;
 	int player;
 	int score;
-	int n_empties;
+	int n_games = 0;
+	int64_t t = -real_clock();
 
 	if (wthor_load(&base, file)) {
-		foreach_wthorgame(wthor, base) {
-			wthorgame_get_board(wthor, base.header.depth, &board, &player);
-			n_empties = board_count_empties(&board);
-			if (n_empties != base.header.depth && !board_is_game_over(&board)) {
-				continue;
-			}
+		if (options.n_batch > 1) {
+			wthor_batch(file, &base, search, options.level, histogram);
+			wthor_free(&base);
+			return;
+		}
 
-			if (player == WHITE) score = 64 - 2 * wthor->theoric_score;
-			else score = 2 * wthor->theoric_score - 64;
-			if (abs(score) > 64) {
-				continue;
-			}
+		foreach_wthorgame(wthor, base) {
+			if (!wthor_get_problem(&base, wthor, &board, &player, &score, false)) continue;
 
 			search_cleanup(search);
 			search_set_board(search, &board, player);
 			search_set_level(search, options.level, base.header.depth);
 			search_run(search);
 			++histogram[search->result->score + 64][(score + 64) / 2];
+			++n_games;
 		}
+		wthor_print_speed(n_games, t + real_clock());
 		wthor_free(&base);
 	}
 	return;
@@ -684,290 +945,1810 @@ void base_append(Base *base, const Game *game)
 }
 
 /**
- * @brief Make games unique in the game database.
+ * @brief Games of a database to make unique, processed by several threads.
+ */
+typedef struct BaseUnique {
+	Base *base;               /**< game database */
+	uint32_t *key;            /**< game keys */
+	uint8_t (*move)[60];      /**< game moves, in their symetric unique form (or NULL) */
+	_Atomic int i;            /**< next games to process */
+} BaseUnique;
+
+/**
+ * @brief Get the moves of a game in a form unique among its symetries.
  *
- * @param base Game base.
+ * @param game Game.
+ * @param move Moves (output).
  */
-void base_unique(Base *base)
+static void game_unique_moves(const Game *game, uint8_t move[60])
 {
-	int i, j, k;
-	bool found;
-
-	for (i = k = 0; i < base->n_games; ++i) {
-		for (j = 0, found = false; j < k && !found; ++j)
-			found = game_equals(base->game + j, base->game + i);
-		if (!found) base->game[k++] = base->game[i];
+	uint8_t sym_move[60];
+	Board sym;
+	int s, i;
+
+	memcpy(move, game->move, 60);
+	for (s = 1; s < 8; ++s) {
+		board_symetry(&game->initial_board, s, &sym);
+		if (board_equal(&sym, &game->initial_board)) {
+			for (i = 0; i < 60; ++i) sym_move[i] = symetry(game->move[i], s);
+			if (memcmp(sym_move, move, 60) < 0) memcpy(move, sym_move, 60);
+		}
 	}
-
-	base->n_games = k;
 }
 
 /**
- * @brief Load a game database.
+ * @brief Compute a game key, from its moves, players & date.
  *
- * @param base Game base.
- * @param file Game filename.
+ * @param game Game.
+ * @param move Game moves.
+ * @return The key.
  */
-bool base_load(Base *base, const char *file)
+static uint32_t game_key(const Game *game, const uint8_t move[60])
 {
-	void (*load)(Game*, FILE*) = game_import_text;
-	Game game;
-	FILE *f;
-	char ext[8];
-	int l;
-	WthorHeader header;
-
-	l = strlen(file); strcpy(ext, file + l - 4); string_to_lowercase(ext);
-	if (strcmp(ext, ".txt") == 0) load = game_import_text;
-	else if (strcmp(ext, ".ggf") == 0) load = game_import_ggf;
-	else if (strcmp(ext, ".sgf") == 0) load = game_import_sgf;
-	else if (strcmp(ext, ".pgn") == 0) load = game_import_pgn;
-	else if (strcmp(ext, ".wtb") == 0) load = game_import_wthor;
-	else if (strcmp(ext, ".edx") == 0) load = game_read;
-	else {
-		warn("Unknown game format extension: %s\n", ext);
-		return false;
-	}
+	uint32_t key = 0;
+	uint64_t x;
+	int i, j;
 
-	if (load == game_import_wthor) f = fopen(file, "rb");
-	else f = fopen(file, "r");
-	if (f == NULL) {
-		warn("Cannot open file %s\n", file);
-		return false;
+	for (i = 0; i < 56; i += 8) {
+		memcpy(&x, move + i, 8);
+		key = crc32c_u64(key, x);
 	}
-
-	info("loading games...");
-	if (load == game_import_wthor) wthor_header_read(&header, f);
-	for (;;) {
-		load(&game, f);
-		if (ferror(f) || feof(f)) break;
-		base_append(base, &game);
+	for (; i < 60; ++i) key = crc32c_u8(key, move[i]);
+	for (j = 0; j < 2; ++j) {
+		for (i = 0; i < 32 && game->name[j][i]; ++i) key = crc32c_u8(key, game->name[j][i]);
+		key = crc32c_u8(key, 0);
 	}
-	info("done (%d games loaded)\n", base->n_games);
-
-	fclose(f);
+	key = crc32c_u64(key, ((uint64_t) (uint16_t) game->date.year << 40) | ((uint64_t) game->date.month << 32) | ((uint64_t) game->date.day << 24)
+		| (game->date.hour << 16) | (game->date.minute << 8) | game->date.second);
 
-	return base->n_games > 0;
+	return key;
 }
 
 /**
- * @brief Save a game database.
+ * @brief Compute the keys of the games, chunk by chunk.
  *
- * @param base Game base.
- * @param file Game filename.
+ * @param v Games to make unique.
+ * @return thrd_success.
  */
-void base_save(const Base *base, const char *file)
+static int base_unique_thread(void *v)
 {
-	void (*save)(const Game*, FILE*)= game_export_text;
-	FILE *f;
-	char ext[8];
-	int i, l;
-	WthorBase wbase;
-	Base old;
-
-	l = strlen(file); strcpy(ext, file + l - 4); string_to_lowercase(ext);
-	if (strcmp(ext, ".txt") == 0) save = game_export_text;
-	else if (strcmp(ext, ".ggf") == 0) save = game_export_ggf;
-	else if (strcmp(ext, ".sgf") == 0) save = game_export_sgf;
-	else if (strcmp(ext, ".pgn") == 0) save = game_export_pgn;
-	else if (strcmp(ext, ".wtb") == 0) {
-		wthor_load(&wbase, file);
-		base_to_wthor(base, &wbase);
-		wthor_save(&wbase, file);
-		wthor_free(&wbase);
-		return;
-	} else if (strcmp(ext, ".edx") == 0) save = game_write;
-	else {
-		warn("Unknown game format extension: %s\n", ext);
-		return;
+	BaseUnique *unique = (BaseUnique*) v;
+	const Game *game;
+	int i, j, n;
+
+	while ((i = atomic_fetch_add(&unique->i, BASE_UNIQUE_CHUNK)) < unique->base->n_games) {
+		n = MIN(i + BASE_UNIQUE_CHUNK, unique->base->n_games);
+		for (j = i; j < n; ++j) {
+			game = unique->base->game + j;
+			if (unique->move) {
+				game_unique_moves(game, unique->move[j]);
+				unique->key[j] = game_key(game, unique->move[j]);
+			} else {
+				unique->key[j] = game_key(game, game->move);
+			}
+		}
 	}
 
-	base_init(&old);
-	base_load(&old, file);
-	for (i = 0; i < base->n_games; ++i) {
-		base_append(&old, base->game + i);
-	}
+	return thrd_success;
+}
 
-	f = fopen(file, "w");
-	if (f == NULL) {
-		warn("Cannot open file %s\n", file);
-		return;
-	}
-	for (i = 0; i < old.n_games && !ferror(f); ++i) {
-		save(old.game + i, f);
-	}
+/**
+ * @brief Test if two games of a database are identical.
+ *
+ * @param unique Games to make unique.
+ * @param i First game.
+ * @param j Second game.
+ * @return true if the games are equal (or symetric).
+ */
+static bool base_game_equals(const BaseUnique *unique, const int i, const int j)
+{
+	Game game_1, game_2;
 
-	fclose(f);
+	if (unique->key[i] != unique->key[j]) return false;
+	if (unique->move == NULL) return game_equals(unique->base->game + i, unique->base->game + j);
 
+	game_1 = unique->base->game[i];
+	game_2 = unique->base->game[j];
+	memcpy(game_1.move, unique->move[i], 60);
+	memcpy(game_2.move, unique->move[j], 60);
+	game_1.hash = game_2.hash = 0;
+	return game_equals(&game_1, &game_2);
 }
 
-
 /**
- * @brief Convert a game database to a set of problems.
+ * @brief Make games unique in the game database.
+ *
+ * The game keys are computed by several threads, then each game is looked up
+ * in a hash table of the kept games. The first occurrence of each game is kept,
+ * in the same order.
  *
  * @param base Game base.
- * @param n_empties Number of empties.
- * @param problem Problems filename.
+ * @param symetric Also remove games identical to a symetry of a kept game.
  */
-void base_to_problem(Base *base, const int n_empties, const char *problem)
+void base_unique(Base *base, const bool symetric)
 {
-	int i;
-	Board board;
-	char s[80];
-	FILE *f;
-
-	f = fopen(problem, "w");
+	BaseUnique unique = {.base = base};
+	thrd_t thread[MAX_THREADS];
+	const int n_threads = MIN(options.n_task, (base->n_games + BASE_UNIQUE_CHUNK - 1) / BASE_UNIQUE_CHUNK);
+	unsigned int size = 1024, mask, j;
+	int *index;
+	bool *duplicate;
+	int i, k, t;
+
+	while (size < 2 * (unsigned int) base->n_games) size *= 2;
+	mask = size - 1;
+
+	unique.key = (uint32_t*) malloc(base->n_games * sizeof (uint32_t) + 1);
+	unique.move = symetric ? (uint8_t (*)[60]) malloc(base->n_games * 60 + 1) : NULL;
+	index = (int*) malloc(size * sizeof (int));
+	duplicate = (bool*) malloc(base->n_games + 1);
+	if (unique.key == NULL || (symetric && unique.move == NULL) || index == NULL || duplicate == NULL) {
+		error("cannot allocate memory to make the base unique");
+	} else {
+		atomic_init(&unique.i, 0);
+		for (t = 1; t < n_threads; ++t) thrd_create(thread + t, base_unique_thread, &unique);
+		base_unique_thread(&unique);
+		for (t = 1; t < n_threads; ++t) thrd_join(thread[t], NULL);
+
+		for (j = 0; j < size; ++j) index[j] = -1;
+		for (i = 0; i < base->n_games; ++i) {
+			for (j = unique.key[i] & mask; index[j] >= 0 && !base_game_equals(&unique, index[j], i); j = (j + 1) & mask) ;
+			duplicate[i] = (index[j] >= 0);
+			if (!duplicate[i]) index[j] = i;
+		}
 
-	for (i = 0; i < base->n_games; ++i) {
-		if (game_get_board(base->game + i, 60 - n_empties, &board)) {
-			board_to_string(&board, n_empties & 1, s);
-			fprintf(f, "%s\n", s);
+		for (i = k = 0; i < base->n_games; ++i) {
+			if (!duplicate[i]) base->game[k++] = base->game[i];
 		}
+		base->n_games = k;
 	}
 
-	fclose(f);
+	free(duplicate);
+	free(index);
+	free(unique.move);
+	free(unique.key);
 }
 
 /**
- * @brief Convert a game database to a set of problems.
+ * @brief Parse a wthor header from the start of a mapped file.
  *
- * @param base Game base.
- * @param n_empties Number of empties.
- * @param problem Problems filename.
+ * @param wheader Wthor's file header.
+ * @param s Mapped file start (16 bytes).
  */
-void base_to_FEN(Base *base, const int n_empties, const char *problem)
+static void wthor_header_parse(WthorHeader *wheader, const unsigned char *s)
 {
-	int i;
-	Board board;
-	FILE *f;
+	wheader->century = s[0];
+	wheader->year = s[1];
+	wheader->month = s[2];
+	wheader->day = s[3];
+	memcpy(&wheader->n_games, s + 4, 4); // ok only on intel-x86 endianness.
+	memcpy(&wheader->n, s + 8, 2);
+	memcpy(&wheader->game_year, s + 10, 2);
+	wheader->board_size = s[12];
+	wheader->game_type = s[13];
+	wheader->depth = s[14];
+	wheader->reserved = s[15];
+}
 
-	f = fopen(problem, "w");
+/**
+ * @brief Get the lowercase extension of a base file name.
+ *
+ * @param file Game filename.
+ * @param ext Extension (output).
+ */
+static void base_file_extension(const char *file, char ext[8])
+{
+	const int l = strlen(file);
 
-	for (i = 0; i < base->n_games; ++i) {
-		if (game_get_board(base->game + i, 60 - n_empties, &board)) {
-			board_print_FEN(&board, n_empties & 1, f);
-			putc('\n', f);
+	strncpy(ext, file + (l > 4 ? l - 4 : 0), 7); ext[7] = '\0';
+	string_to_lowercase(ext);
+}
+
+/**
+ * @brief A chunk of a text base file, parsed by a thread.
+ */
+typedef struct BaseTextChunk {
+	const char *begin;         /**< first character */
+	const char *end;           /**< end of the chunk, at a guessed game boundary */
+	const char *stop;          /**< first character left unparsed */
+	Base base;                 /**< parsed games */
+	bool eof;                  /**< end of the file reached */
+} BaseTextChunk;
+
+/**
+ * @brief Chunks of a text base file, parsed by several threads.
+ */
+typedef struct BaseTextBatch {
+	BaseReader *reader;        /**< base reader */
+	_Atomic int i;             /**< next chunk to parse */
+} BaseTextBatch;
+
+/**
+ * @brief Guess where a game begins in a text base file.
+ *
+ * The guess needs not be right, as the chunks are checked to join
+ * after being parsed.
+ *
+ * @param reader Base reader.
+ * @param s Position in the file, from where to look for a game.
+ * @return The start of a game, or the end of the file.
+ */
+static const char* base_text_boundary(const BaseReader *reader, const char *s)
+{
+	const char *end = (const char*) reader->map + reader->size;
+	const char *p, *q;
+
+	if (reader->load == game_import_text_source) { // next line
+		p = (const char*) memchr(s, '\n', end - s);
+		if (p) return p + 1;
+	} else if (reader->load == game_import_pgn_source) { // a tag line after a line that is not a tag
+		for (p = s; (p = (const char*) memchr(p, '\n', end - p)) != NULL && p + 1 < end; ++p) {
+			if (p[1] == '[') {
+				for (q = p; q > s && q[-1] != '\n'; --q) ;
+				if (q > s && *q != '[') return p + 1;
+			}
+		}
+	} else { // ggf & sgf: right after the closing parenthesis of a game followed by "(;"
+		for (p = s; (p = (const char*) memchr(p, '(', end - p)) != NULL && p + 1 < end; ++p) {
+			if (p[1] == ';') {
+				for (q = p; q > s && isspace((unsigned char) q[-1]); --q) ;
+				if (q > s && q[-1] == ')') return q;
+			}
 		}
 	}
 
-	fclose(f);
+	return end;
 }
 
 /**
- * @brief Base analysis.
+ * @brief Parse the games of a chunk of a text base file.
  *
- * @param base Game base.
- * @param search Search engine.
- * @param n_empties Number of empties.
- * @param apply_correction Correct bad moves from the games.
+ * The parser may read past the end of the chunk, to complete its last game.
+ *
+ * @param reader Base reader.
+ * @param chunk Chunk.
  */
-void base_analyze(Base *base, Search *search, const int n_empties, const bool apply_correction)
+static void base_text_parse(const BaseReader *reader, BaseTextChunk *chunk)
 {
-	int i;
-	int n_error;
+	GameSource src = {.f = NULL, .s = chunk->begin, .end = (const char*) reader->map + reader->size, .eof = false};
+	Game game;
 
-	for (i = 0; i < base->n_games; ++i) {
-		if (game_score(base->game + i) == 0) continue;
-		game_export_text(base->game + i, stdout);
-		n_error = game_analyze(base->game + i, search, n_empties, apply_correction);
-		if (n_error) {
-			printf("Game #%d contains %d errors", i, n_error);
-			if (apply_correction) {
-				if (game_analyze(base->game + i, search, n_empties, false)) printf("... correction failed! ***BUG DETECTED!***\n");
-				else printf("... corrected!\n");
-			} else putchar('\n');
-		}
-		printf("%d/%d %.1f %% done.\r", i + 1, base->n_games, 100.0 * (i + 1) / base->n_games); fflush(stdout);
+	chunk->base.n_games = 0;
+	while (src.s < chunk->end) {
+		reader->load(&game, &src);
+		if (src.eof) break;
+		base_append(&chunk->base, &game);
 	}
+	chunk->stop = src.s;
+	chunk->eof = src.eof;
 }
 
 /**
- * @brief Base analysis.
+ * @brief Parse chunks of a text base file until none is left.
  *
- * @param base Game base.
- * @param search Search engine.
+ * @param v Chunks to parse (cast as void).
+ * @return thrd_success.
  */
-void base_complete(Base *base, Search *search)
+static int base_text_thread(void *v)
 {
-	int i, n;
-	int completed;
+	BaseTextBatch *batch = (BaseTextBatch*) v;
+	int i;
 
-	for (i = n = 0; i < base->n_games; ++i) {
-		completed = 0;
-		if (game_complete(base->game + i, search) > 0) completed = 1;
-		n += completed;
-		if (completed || (i % 1000) == 0) {
-			printf("%d/%d games completed (%.1f %% done).\r", n, i + 1, 100.0 * (i + 1) / base->n_games); fflush(stdout);
-		}
+	while ((i = atomic_fetch_add(&batch->i, 1)) < batch->reader->n_chunks) {
+		base_text_parse(batch->reader, batch->reader->chunk + i);
 	}
-	printf("%d/%d games completed (all done).          \n", n, i + 1);
+
+	return thrd_success;
 }
 
 /**
- * @brief Base Compare.
+ * @brief Parse the next chunks of a text base file.
  *
- * Display the number of positions two base files have in common.
+ * The chunks are parsed by several threads. A chunk that does not start
+ * where the parsing of the previous one stopped is parsed again, so the
+ * games are the same as those of a sequential reading.
  *
- * @param file_1 Game base file.
- * @param file_2 Game base file.
+ * @param reader Base reader.
  */
-void base_compare(const char *file_1, const char *file_2)
+static void base_reader_parse(BaseReader *reader)
 {
-	Base base_1, base_2;
-	PositionHash hash;
-	Board board;
-	int i, j;
-	int64_t n_1, n_2, n_2_only;
-
-	base_init(&base_1);
-	base_init(&base_2);
-	n_1 = 0;
-	n_2 = 0;
-	n_2_only = 0;
-
-	base_load(&base_1, file_1);
-	positionhash_init(&hash, options.hash_table_size);
-	for (i = 0; i < base_1.n_games; ++i) {
-		Game *game = base_1.game + i;
-		board = game->initial_board;
-		for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
-			if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
-			if (positionhash_append(&hash, &board)) {
-				++n_1;
-			}
-		}
+	BaseTextBatch batch = {.reader = reader};
+	thrd_t thread[MAX_THREADS];
+	const char *s = (const char*) reader->map + reader->offset;
+	const char *end = (const char*) reader->map + reader->size;
+	int i, t, n_threads;
+
+	for (i = 0; i < reader->max_chunks && s < end; ++i) {
+		reader->chunk[i].begin = s;
+		s = (end - s > BASE_TEXT_CHUNK) ? base_text_boundary(reader, s + BASE_TEXT_CHUNK) : end;
+		reader->chunk[i].end = s;
 	}
-	base_free(&base_1);
-
-	base_load(&base_2, file_2);
-	for (i = 0; i < base_2.n_games; ++i) {
-		Game *game = base_2.game + i;
-		board = game->initial_board;
-		for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
-			if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
-			if (positionhash_append(&hash, &board)) {
-				++n_2_only;
-			}
+	reader->n_chunks = i;
+
+	n_threads = MIN(options.n_task, reader->n_chunks);
+	atomic_init(&batch.i, 0);
+	for (t = 1; t < n_threads; ++t) thrd_create(thread + t, base_text_thread, &batch);
+	base_text_thread(&batch);
+	for (t = 1; t < n_threads; ++t) thrd_join(thread[t], NULL);
+
+	for (i = 0; i < reader->n_chunks; ++i) {
+		if (i > 0 && reader->chunk[i].begin != reader->chunk[i - 1].stop) {
+			reader->chunk[i].begin = reader->chunk[i - 1].stop;
+			base_text_parse(reader, reader->chunk + i);
 		}
+		if (reader->chunk[i].eof) reader->n_chunks = i + 1;
 	}
 
-	positionhash_delete(&hash);
-	positionhash_init(&hash, options.hash_table_size);
-	for (i = 0; i < base_2.n_games; ++i) {
-		Game *game = base_2.game + i;
-		board = game->initial_board;
-		for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
-			if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
-			if (positionhash_append(&hash, &board)) {
-				++n_2;
-			}
+	reader->offset = reader->chunk[reader->n_chunks - 1].stop - (const char*) reader->map;
+	reader->i_chunk = reader->i_game = 0;
+}
+
+/**
+ * @brief Open a base file to read its games one by one.
+ *
+ * @param reader Base reader.
+ * @param file Game filename.
+ * @return true if the file is opened.
+ */
+bool base_reader_open(BaseReader *reader, const char *file)
+{
+	char ext[8];
+	FILE *f;
+	int i;
+
+	memset(reader, 0, sizeof *reader);
+	reader->n_games = -1;
+
+	base_file_extension(file, ext);
+	if (strcmp(ext, ".txt") == 0) reader->load = game_import_text_source;
+	else if (strcmp(ext, ".ggf") == 0) reader->load = game_import_ggf_source;
+	else if (strcmp(ext, ".sgf") == 0) reader->load = game_import_sgf_source;
+	else if (strcmp(ext, ".pgn") == 0) reader->load = game_import_pgn_source;
+	else if (strcmp(ext, ".wtb") == 0) reader->record_size = sizeof (WthorGame);
+	else if (strcmp(ext, ".edx") == 0) reader->record_size = sizeof (Game);
+	else {
+		warn("Unknown game format extension: %s\n", ext);
+		return false;
+	}
+
+	reader->map = (unsigned char*) file_map(file, &reader->size);
+	if (reader->map == NULL) { // an empty file cannot be mapped
+		if ((f = fopen(file, "rb")) == NULL) {
+			warn("Cannot open file %s\n", file);
+			return false;
+		}
+		fclose(f);
+		reader->size = 0;
+	}
+
+	if (reader->record_size) {
+		if (reader->record_size == sizeof (WthorGame)) {
+			if (reader->size >= 16) wthor_header_parse(&reader->header, reader->map);
+			reader->offset = 16;
+		}
+		reader->n_games = reader->size > reader->offset ? (reader->size - reader->offset) / reader->record_size : 0;
+	} else {
+		reader->max_chunks = BASE_TEXT_BATCH * MAX(1, MIN(options.n_task, MAX_THREADS));
+		reader->chunk = (BaseTextChunk*) malloc(reader->max_chunks * sizeof (BaseTextChunk));
+		if (reader->chunk == NULL) fatal_error("Cannot allocate the chunks of a base reader.\n");
+		for (i = 0; i < reader->max_chunks; ++i) base_init(&reader->chunk[i].base);
+	}
+
+	return true;
+}
+
+/**
+ * @brief Read the next game of a base file.
+ *
+ * Edx games are returned from the memory map, and text games from the parsed
+ * chunks, without copy.
+ *
+ * @param reader Base reader.
+ * @return The next game, or NULL at the end of the file.
+ */
+const Game* base_reader_next(BaseReader *reader)
+{
+	const Game *game = &reader->game;
+	const BaseTextChunk *chunk;
+
+	if (reader->record_size) {
+		if (reader->i >= reader->n_games) return NULL;
+		if (reader->record_size == sizeof (Game)) {
+			game = (const Game*) (reader->map + reader->offset);
+		} else {
+			reader->wthor = (const WthorGame*) (reader->map + reader->offset);
+			wthor_to_game(reader->wthor, &reader->game);
+		}
+		reader->offset += reader->record_size;
+	} else {
+		for (;;) {
+			if (reader->i_chunk < reader->n_chunks) {
+				chunk = reader->chunk + reader->i_chunk;
+				if (reader->i_game < chunk->base.n_games) break;
+				++reader->i_chunk;
+				reader->i_game = 0;
+			} else if (reader->offset < reader->size) {
+				base_reader_parse(reader);
+			} else return NULL;
+		}
+		game = chunk->base.game + reader->i_game++;
+	}
+	++reader->i;
+
+	return game;
+}
+
+/**
+ * @brief Close a base reader.
+ *
+ * @param reader Base reader.
+ */
+void base_reader_close(BaseReader *reader)
+{
+	int i;
+
+	for (i = 0; i < reader->max_chunks; ++i) base_free(&reader->chunk[i].base);
+	free(reader->chunk);
+	file_unmap(reader->map, reader->size);
+	reader->chunk = NULL;
+	reader->max_chunks = reader->n_chunks = 0;
+	reader->map = NULL;
+}
+
+/**
+ * @brief Open a base file to append games to it one by one.
+ *
+ * @param writer Base writer.
+ * @param file Game filename.
+ * @return true if the file is opened.
+ */
+bool base_writer_open(BaseWriter *writer, const char *file)
+{
+	char ext[8];
+	FILE *f;
+
+	memset(writer, 0, sizeof *writer);
+	wthor_init(&writer->wthor);
+
+	base_file_extension(file, ext);
+	if (strcmp(ext, ".txt") == 0) writer->save = game_export_text;
+	else if (strcmp(ext, ".ggf") == 0) writer->save = game_export_ggf;
+	else if (strcmp(ext, ".sgf") == 0) writer->save = game_export_sgf;
+	else if (strcmp(ext, ".pgn") == 0) writer->save = game_export_pgn;
+	else if (strcmp(ext, ".edx") == 0) writer->save = game_write;
+	else if (strcmp(ext, ".wtb") != 0) {
+		warn("Unknown game format extension: %s\n", ext);
+		return false;
+	}
+
+	if (writer->save) {
+		writer->f = fopen(file, writer->save == game_write ? "ab" : "a");
+	} else {
+		path_get_dir(file, writer->path); strcat(writer->path, "WTHOR.JOU");
+		wthor_players_load(&writer->wthor, writer->path);
+		if ((f = fopen(file, "r+b")) != NULL && wthor_header_read(&writer->wthor.header, f) && writer->wthor.header.board_size == 8) {
+			writer->n_games = writer->wthor.header.n_games;
+			if (fseek(f, 16 + (long) writer->n_games * sizeof (WthorGame), SEEK_SET) == 0) writer->f = f;
+			else fclose(f);
+		} else {
+			if (f) fclose(f);
+			if ((writer->f = fopen(file, "w+b")) != NULL) {
+				wthor_header_set(&writer->wthor.header, 0, 0, 0);
+				wthor_header_write(&writer->wthor.header, writer->f);
+			}
+		}
+	}
+
+	if (writer->f == NULL) {
+		warn("Cannot open file %s\n", file);
+		wthor_free(&writer->wthor);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Append a game to a base file.
+ *
+ * @param writer Base writer.
+ * @param game Game.
+ */
+void base_writer_write(BaseWriter *writer, const Game *game)
+{
+	WthorGame thor;
+
+	if (writer->save) {
+		writer->save(game, writer->f);
+	} else {
+		game_to_wthor(game, &thor);
+		thor.black = wthor_player_get(&writer->wthor, game->name[BLACK]);
+		thor.white = wthor_player_get(&writer->wthor, game->name[WHITE]);
+		fwrite(&thor, sizeof (WthorGame), 1, writer->f);
+	}
+	++writer->n_games;
+}
+
+/**
+ * @brief Close a base writer.
+ *
+ * The header & the players of a wthor file are updated.
+ *
+ * @param writer Base writer.
+ */
+void base_writer_close(BaseWriter *writer)
+{
+	if (writer->f == NULL) return;
+
+	if (writer->save == NULL) {
+		wthor_header_set(&writer->wthor.header, writer->n_games, 0, 0);
+		if (fseek(writer->f, 0, SEEK_SET) == 0) wthor_header_write(&writer->wthor.header, writer->f);
+		wthor_players_save(&writer->wthor, writer->path);
+		wthor_free(&writer->wthor);
+	}
+	if (ferror(writer->f)) warn("Error while writing games\n");
+	fclose(writer->f);
+	writer->f = NULL;
+}
+
+/**
+ * @brief Load a game database.
+ *
+ * @param base Game base.
+ * @param file Game filename.
+ */
+bool base_load(Base *base, const char *file)
+{
+	BaseReader reader;
+	const Game *game;
+
+	if (!base_reader_open(&reader, file)) return false;
+
+	info("loading games...");
+	foreach_base_game(game, reader) {
+		base_append(base, game);
+	}
+	info("done (%d games loaded)\n", base->n_games);
+
+	base_reader_close(&reader);
+
+	return base->n_games > 0;
+}
+
+/**
+ * @brief Save a game database.
+ *
+ * The games are appended to the file.
+ *
+ * @param base Game base.
+ * @param file Game filename.
+ */
+void base_save(const Base *base, const char *file)
+{
+	BaseWriter writer;
+	int i;
+
+	if (base_writer_open(&writer, file)) {
+		for (i = 0; i < base->n_games; ++i) {
+			base_writer_write(&writer, base->game + i);
+		}
+		base_writer_close(&writer);
+	}
+}
+
+/**
+ * @brief Convert a game database to another format.
+ *
+ * The games are streamed from a file to the other.
+ *
+ * @param file_in Input game filename.
+ * @param file_out Output game filename.
+ * @return true if some games are converted.
+ */
+bool base_convert(const char *file_in, const char *file_out)
+{
+	BaseReader reader;
+	BaseWriter writer;
+	const Game *game;
+	int n_games = 0;
+
+	if (strcmp(file_in, file_out) == 0) {
+		warn("Cannot convert %s into itself\n", file_in);
+		return false;
+	}
+
+	if (base_reader_open(&reader, file_in)) {
+		if (base_writer_open(&writer, file_out)) {
+			foreach_base_game(game, reader) {
+				base_writer_write(&writer, game);
+			}
+			n_games = reader.i;
+			base_writer_close(&writer);
+		}
+		base_reader_close(&reader);
+	}
+	info("<%d games converted>\n", n_games);
+
+	return n_games > 0;
+}
+
+/**
+ * @brief Convert a game database to a set of problems.
+ *
+ * @param file Game base filename.
+ * @param n_empties Number of empties.
+ * @param problem Problems filename.
+ */
+void base_to_problem(const char *file, const int n_empties, const char *problem)
+{
+	BaseReader reader;
+	const Game *game;
+	Board board;
+	char s[80];
+	FILE *f;
+
+	if (!base_reader_open(&reader, file)) return;
+
+	f = fopen(problem, "w");
+	if (f == NULL) {
+		warn("Cannot open file %s\n", problem);
+	} else {
+		foreach_base_game(game, reader) {
+			if (game_get_board(game, 60 - n_empties, &board)) {
+				board_to_string(&board, n_empties & 1, s);
+				fprintf(f, "%s\n", s);
+			}
+		}
+		fclose(f);
+	}
+
+	base_reader_close(&reader);
+}
+
+/**
+ * @brief Convert a game database to a set of problems.
+ *
+ * @param file Game base filename.
+ * @param n_empties Number of empties.
+ * @param problem Problems filename.
+ */
+void base_to_FEN(const char *file, const int n_empties, const char *problem)
+{
+	BaseReader reader;
+	const Game *game;
+	Board board;
+	FILE *f;
+
+	if (!base_reader_open(&reader, file)) return;
+
+	f = fopen(problem, "w");
+	if (f == NULL) {
+		warn("Cannot open file %s\n", problem);
+	} else {
+		foreach_base_game(game, reader) {
+			if (game_get_board(game, 60 - n_empties, &board)) {
+				board_print_FEN(&board, n_empties & 1, f);
+				putc('\n', f);
+			}
+		}
+		fclose(f);
+	}
+
+	base_reader_close(&reader);
+}
+
+/** Result of a game analyzed or completed by a batch */
+typedef struct BaseAnalysis {
+	Game *game;                  /**<! corrected or completed game (or NULL if unchanged) */
+	int n_error;                 /**<! number of errors (or of completing iterations) */
+	bool is_failed;              /**<! correction failed? */
+	bool is_done;                /**<! analysis done? */
+} BaseAnalysis;
+
+/** Games of a base analyzed or completed simultaneously */
+typedef struct BaseBatch {
+	Base *base;                  /**<! game base */
+	BaseAnalysis *analysis;      /**<! analysis results */
+	_Atomic int i;               /**<! next game to analyze */
+	int i_print;                 /**<! next game to report */
+	int n_empties;               /**<! number of empties to analyze (or -1 to complete the games) */
+	bool apply_correction;       /**<! correct bad moves? */
+	int first;                   /**<! index of the first game, in the whole base */
+	int n_total;                 /**<! number of games of the whole base (or -1 if unknown) */
+	int n_completed;             /**<! number of completed games */
+	HashTable hash_table;        /**<! hash table shared by the searches (with -batch-shared-hash) */
+	mtx_t mutex;                 /**<! lock */
+} BaseBatch;
+
+/** A search analyzing games from a batch */
+typedef struct BaseWorker {
+	Search search;               /**<! search */
+	HashTable hash_table;        /**<! own hash table, put aside while sharing the batch one */
+	BaseBatch *batch;            /**<! batch */
+	thrd_t thread;               /**<! thread */
+} BaseWorker;
+
+/**
+ * @brief Silent search observer.
+ *
+ * Search results of completed games would be printed out of order.
+ *
+ * @param result Search result (unused).
+ */
+static void base_batch_observer(Result *result)
+{
+	(void) result;
+}
+
+/**
+ * @brief Print the progress of a base analysis.
+ *
+ * @param n Number of games done.
+ * @param n_total Number of games of the base (or -1 if unknown).
+ */
+static void base_print_progress(const int n, const int n_total)
+{
+	if (n_total > 0) printf("%d/%d %.1f %% done.\r", n, n_total, 100.0 * n / n_total);
+	else printf("%d games done.\r", n);
+	fflush(stdout);
+}
+
+/**
+ * @brief Report an analyzed game, as base_analyze or base_complete does.
+ *
+ * The corrected or completed game replaces the original one.
+ *
+ * @param batch Batch.
+ * @param i Game index.
+ */
+static void base_batch_report(BaseBatch *batch, const int i)
+{
+	Base *base = batch->base;
+	BaseAnalysis *analysis = batch->analysis + i;
+
+	if (batch->n_empties < 0) {
+		if (analysis->n_error > 0) ++batch->n_completed;
+		if (analysis->n_error > 0 || (i % 1000) == 0) {
+			printf("%d/%d games completed (%.1f %% done).\r", batch->n_completed, i + 1, 100.0 * (i + 1) / base->n_games); fflush(stdout);
+		}
+	} else if (game_score(base->game + i) != 0) {
+		game_export_text(base->game + i, stdout);
+		if (analysis->n_error) {
+			printf("Game #%d contains %d errors", batch->first + i, analysis->n_error);
+			if (batch->apply_correction) {
+				if (analysis->is_failed) printf("... correction failed! ***BUG DETECTED!***\n");
+				else printf("... corrected!\n");
+			} else putchar('\n');
+		}
+		base_print_progress(batch->first + i + 1, batch->n_total);
+	}
+
+	if (analysis->game) {
+		base->game[i] = *analysis->game;
+		free(analysis->game);
+		analysis->game = NULL;
+	}
+}
+
+/**
+ * @brief Analyze or complete games from a batch, until none is left.
+ *
+ * Each game is analyzed on a copy, so its original moves can still be reported.
+ *
+ * @param v Worker (cast as void).
+ * @return thrd_success.
+ */
+static int base_batch_run(void *v)
+{
+	BaseWorker *worker = (BaseWorker*) v;
+	BaseBatch *batch = worker->batch;
+	Search *search = &worker->search;
+	BaseAnalysis *analysis;
+	Game game;
+	int i;
+
+	while ((i = atomic_fetch_add(&batch->i, 1)) < batch->base->n_games) {
+		analysis = batch->analysis + i;
+		game = batch->base->game[i];
+		if (batch->n_empties < 0) {
+			analysis->n_error = game_complete(&game, search);
+		} else if (game_score(&game) != 0) {
+			analysis->n_error = game_analyze(&game, search, batch->n_empties, batch->apply_correction);
+			if (analysis->n_error && batch->apply_correction) {
+				analysis->is_failed = (game_analyze(&game, search, batch->n_empties, false) != 0);
+			}
+		}
+		if (analysis->n_error > 0 && (batch->n_empties < 0 || batch->apply_correction)) {
+			analysis->game = (Game*) malloc(sizeof (Game));
+			if (analysis->game == NULL) fatal_error("base: cannot allocate a corrected game\n");
+			*analysis->game = game;
+		}
+
+		mtx_lock(&batch->mutex);
+			analysis->is_done = true;
+			while (batch->i_print < batch->base->n_games && batch->analysis[batch->i_print].is_done) {
+				base_batch_report(batch, batch->i_print++);
+			}
+		mtx_unlock(&batch->mutex);
+	}
+
+	return thrd_success;
+}
+
+/**
+ * @brief Analyze or complete the games of a base, several simultaneously.
+ *
+ * options.n_batch searches run in parallel, each one with its share of the
+ * tasks and of the hash table memory. The games are corrected or completed
+ * as by the serial loop and reported in the same order. With
+ * -batch-shared-hash, the searches share a single hash table instead, to
+ * reuse the endgames common to several games; the scores are unchanged, but
+ * a correction may then pick another line among equally good ones.
+ *
+ * @param base Game base.
+ * @param search Search engine, providing the search settings.
+ * @param n_empties Number of empties to analyze (or -1 to complete the games).
+ * @param apply_correction Correct bad moves from the games.
+ * @param first Index of the first game, in the whole base.
+ * @param n_total Number of games of the whole base (or -1 if unknown).
+ */
+static void base_batch(Base *base, Search *search, const int n_empties, const bool apply_correction, const int first, const int n_total)
+{
+	BaseBatch batch;
+	BaseWorker *worker;
+	const int n_batch = options.n_batch;
+	int i;
+
+	batch.analysis = (BaseAnalysis*) calloc(base->n_games + 1, sizeof (BaseAnalysis));
+	worker = (BaseWorker*) malloc(n_batch * sizeof (BaseWorker));
+	if (batch.analysis == NULL || worker == NULL) fatal_error("base: cannot allocate the games to analyze\n");
+
+	batch.base = base;
+	atomic_init(&batch.i, 0);
+	batch.i_print = 0;
+	batch.n_empties = n_empties;
+	batch.apply_correction = apply_correction;
+	batch.first = first;
+	batch.n_total = n_total;
+	batch.n_completed = 0;
+	mtx_init(&batch.mutex, mtx_plain);
+
+	if (options.batch_shared_hash) {
+		memset(&batch.hash_table, 0, sizeof batch.hash_table);
+		hash_init(&batch.hash_table, 1ull << options.hash_table_size);
+		hash_clear(&batch.hash_table);
+	}
+
+	for (i = 0; i < n_batch; ++i) {
+		search_init_shared(&worker[i].search, n_batch, i);
+		worker[i].search.options.depth = search->options.depth;
+		worker[i].search.options.selectivity = search->options.selectivity;
+		worker[i].search.options.time = search->options.time;
+		worker[i].search.options.time_per_move = search->options.time_per_move;
+		worker[i].search.options.verbosity = 0;
+		worker[i].search.observer = base_batch_observer;
+		worker[i].batch = &batch;
+		if (options.batch_shared_hash) {
+			worker[i].hash_table = worker[i].search.hash_table;
+			worker[i].search.hash_table = batch.hash_table;
+			worker[i].search.options.keep_date = true;
+		}
+	}
+	info("<base: %d games analyzed by %d searches of %d tasks>\n", base->n_games, n_batch, MAX(1, options.n_task / n_batch));
+
+	for (i = 0; i < n_batch; ++i) thrd_create(&worker[i].thread, base_batch_run, worker + i);
+	for (i = 0; i < n_batch; ++i) thrd_join(worker[i].thread, NULL);
+
+	if (n_empties < 0) printf("%d/%d games completed (all done).          \n", batch.n_completed, base->n_games);
+
+	for (i = 0; i < n_batch; ++i) {
+		if (options.batch_shared_hash) worker[i].search.hash_table = worker[i].hash_table;
+		search_free(&worker[i].search);
+	}
+	if (options.batch_shared_hash) hash_free(&batch.hash_table);
+	mtx_destroy(&batch.mutex);
+	free(worker);
+	free(batch.analysis);
+}
+
+/**
+ * @brief Analyze the games of a base, or of a chunk of a base.
+ *
+ * With several -batch searches, the games are analyzed simultaneously.
+ *
+ * @param base Game base.
+ * @param search Search engine.
+ * @param n_empties Number of empties.
+ * @param apply_correction Correct bad moves from the games.
+ * @param first Index of the first game, in the whole base.
+ * @param n_total Number of games of the whole base (or -1 if unknown).
+ */
+static void base_analyze_games(Base *base, Search *search, const int n_empties, const bool apply_correction, const int first, const int n_total)
+{
+	int i;
+	int n_error;
+
+	if (options.n_batch > 1) {
+		base_batch(base, search, MAX(n_empties, 0), apply_correction, first, n_total);
+		return;
+	}
+
+	for (i = 0; i < base->n_games; ++i) {
+		if (game_score(base->game + i) == 0) continue;
+		game_export_text(base->game + i, stdout);
+		n_error = game_analyze(base->game + i, search, n_empties, apply_correction);
+		if (n_error) {
+			printf("Game #%d contains %d errors", first + i, n_error);
+			if (apply_correction) {
+				if (game_analyze(base->game + i, search, n_empties, false)) printf("... correction failed! ***BUG DETECTED!***\n");
+				else printf("... corrected!\n");
+			} else putchar('\n');
+		}
+		base_print_progress(first + i + 1, n_total);
+	}
+}
+
+/**
+ * @brief Base analysis.
+ *
+ * @param base Game base.
+ * @param search Search engine.
+ * @param n_empties Number of empties.
+ * @param apply_correction Correct bad moves from the games.
+ */
+void base_analyze(Base *base, Search *search, const int n_empties, const bool apply_correction)
+{
+	base_analyze_games(base, search, n_empties, apply_correction, 0, base->n_games);
+}
+
+/**
+ * @brief Check the games of a base file.
+ *
+ * The games are streamed from the file and analyzed by chunks, to run in
+ * constant memory.
+ *
+ * @param file Game base filename.
+ * @param search Search engine.
+ * @param n_empties Number of empties.
+ */
+void base_check(const char *file, Search *search, const int n_empties)
+{
+	BaseReader reader;
+	Base chunk;
+	const Game *game;
+	int first = 0;
+
+	if (!base_reader_open(&reader, file)) return;
+
+	base_init(&chunk);
+	do {
+		chunk.n_games = 0;
+		while (chunk.n_games < BASE_ANALYSIS_CHUNK && (game = base_reader_next(&reader)) != NULL) {
+			base_append(&chunk, game);
+		}
+		base_analyze_games(&chunk, search, n_empties, false, first, reader.n_games);
+		first += chunk.n_games;
+	} while (chunk.n_games == BASE_ANALYSIS_CHUNK);
+	base_free(&chunk);
+
+	base_reader_close(&reader);
+}
+
+/**
+ * @brief Base analysis.
+ *
+ * With several -batch searches, the games are completed simultaneously.
+ *
+ * @param base Game base.
+ * @param search Search engine.
+ */
+void base_complete(Base *base, Search *search)
+{
+	int i, n;
+	int completed;
+
+	if (options.n_batch > 1) {
+		base_batch(base, search, -1, false, 0, base->n_games);
+		return;
+	}
+
+	for (i = n = 0; i < base->n_games; ++i) {
+		completed = 0;
+		if (game_complete(base->game + i, search) > 0) completed = 1;
+		n += completed;
+		if (completed || (i % 1000) == 0) {
+			printf("%d/%d games completed (%.1f %% done).\r", n, i + 1, 100.0 * (i + 1) / base->n_games); fflush(stdout);
+		}
+	}
+	printf("%d/%d games completed (all done).          \n", n, i + 1);
+}
+
+/**
+ * @brief A shard of a position set.
+ *
+ * An open addressing hash table of positions, doubling its size when
+ * it is 3/4 full. Empty slots hold an empty board.
+ */
+typedef struct PositionShard {
+	Board *board;              /**< positions */
+	uint64_t mask;             /**< table size - 1 */
+	uint64_t n;                /**< number of positions */
+	SpinLock lock;             /**< lock */
+} PositionShard;
+
+/**
+ * @brief A set of positions, shared by several threads.
+ *
+ * The positions are spread among independently locked shards,
+ * to keep the threads from waiting on each other.
+ */
+typedef struct PositionSet {
+	PositionShard shard[POSITION_SET_SHARDS]; /**< shards */
+} PositionSet;
+
+/**
+ * @brief Initialize a position set.
+ *
+ * @param set Position set.
+ */
+static void position_set_init(PositionSet *set)
+{
+	PositionShard *shard;
+
+	for (shard = set->shard; shard < set->shard + POSITION_SET_SHARDS; ++shard) {
+		shard->mask = 255;
+		shard->n = 0;
+		shard->board = (Board*) calloc(shard->mask + 1, sizeof (Board));
+		if (shard->board == NULL) fatal_error("Cannot allocate a position set.\n");
+		spinlock_init(&shard->lock);
+	}
+}
+
+/**
+ * @brief Free a position set.
+ *
+ * @param set Position set.
+ */
+static void position_set_free(PositionSet *set)
+{
+	PositionShard *shard;
+
+	for (shard = set->shard; shard < set->shard + POSITION_SET_SHARDS; ++shard) free(shard->board);
+}
+
+/**
+ * @brief Get the shard of a position.
+ *
+ * @param set Position set.
+ * @param h Hash code of the position.
+ * @return The shard.
+ */
+static inline PositionShard* position_set_shard(const PositionSet *set, const uint64_t h)
+{
+	return (PositionShard*) set->shard + ((h >> 32) & (POSITION_SET_SHARDS - 1));
+}
+
+/**
+ * @brief Double the size of a shard.
+ *
+ * @param shard Position set shard.
+ */
+static void position_shard_grow(PositionShard *shard)
+{
+	const uint64_t mask = 2 * shard->mask + 1;
+	Board *board = (Board*) calloc(mask + 1, sizeof (Board));
+	uint64_t i, j;
+
+	if (board == NULL) fatal_error("Cannot re-allocate a position set.\n");
+	for (i = 0; i <= shard->mask; ++i) {
+		if (shard->board[i].player | shard->board[i].opponent) {
+			for (j = board_get_hash_code(shard->board + i) & mask; board[j].player | board[j].opponent; j = (j + 1) & mask) ;
+			board[j] = shard->board[i];
+		}
+	}
+	free(shard->board);
+	shard->board = board;
+	shard->mask = mask;
+}
+
+/**
+ * @brief Append a position to a position set.
+ *
+ * @param set Position set.
+ * @param board Position, in its unique symetric form.
+ * @param h Hash code of the position.
+ * @return true if the position is added to the set, false if it was already there.
+ */
+static bool position_set_append(PositionSet *set, const Board *board, const uint64_t h)
+{
+	PositionShard *shard = position_set_shard(set, h);
+	uint64_t i;
+	bool added;
+
+	spinlock_lock(&shard->lock);
+	for (i = h & shard->mask; (shard->board[i].player | shard->board[i].opponent) && !board_equal(shard->board + i, board); i = (i + 1) & shard->mask) ;
+	added = !(shard->board[i].player | shard->board[i].opponent);
+	if (added) {
+		shard->board[i] = *board;
+		if (4 * ++shard->n >= 3 * (shard->mask + 1)) position_shard_grow(shard);
+	}
+	spinlock_unlock(&shard->lock);
+
+	return added;
+}
+
+/**
+ * @brief Test if a position is in a position set.
+ *
+ * The set is not locked: no position should be appended to it at the same time.
+ *
+ * @param set Position set.
+ * @param board Position, in its unique symetric form.
+ * @param h Hash code of the position.
+ * @return true if the position is in the set.
+ */
+static bool position_set_contains(const PositionSet *set, const Board *board, const uint64_t h)
+{
+	const PositionShard *shard = position_set_shard(set, h);
+	uint64_t i;
+
+	for (i = h & shard->mask; shard->board[i].player | shard->board[i].opponent; i = (i + 1) & shard->mask) {
+		if (board_equal(shard->board + i, board)) return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Games of a base whose positions are collected by several threads.
+ */
+typedef struct BaseCompare {
+	const Base *base;          /**< games */
+	PositionSet *set;          /**< positions of the base */
+	const PositionSet *other;  /**< positions of another base (or NULL) */
+	_Atomic int i;             /**< next games to replay */
+	_Atomic int64_t n;         /**< number of positions added to the set */
+	_Atomic int64_t n_common;  /**< number of added positions also in the other base */
+} BaseCompare;
+
+/**
+ * @brief Replay the games, chunk by chunk, and collect their positions.
+ *
+ * @param v Games to replay (cast as void).
+ * @return thrd_success.
+ */
+static int base_compare_thread(void *v)
+{
+	BaseCompare *compare = (BaseCompare*) v;
+	const Game *game;
+	Board board, unique;
+	uint64_t h;
+	int64_t n = 0, n_common = 0;
+	int i, j, k, end;
+
+	while ((i = atomic_fetch_add(&compare->i, BASE_COMPARE_CHUNK)) < compare->base->n_games) {
+		end = MIN(i + BASE_COMPARE_CHUNK, compare->base->n_games);
+		for (k = i; k < end; ++k) {
+			game = compare->base->game + k;
+			board = game->initial_board;
+			for (j = 0; j < 60 && game->move[j] != NOMOVE; ++j) {
+				if (!game_update_board(&board, game->move[j])) break; // BAD MOVE -> end of game
+				board_unique(&board, &unique);
+				h = board_get_hash_code(&unique);
+				if (position_set_append(compare->set, &unique, h)) {
+					++n;
+					if (compare->other && position_set_contains(compare->other, &unique, h)) ++n_common;
+				}
+			}
+		}
+	}
+	atomic_fetch_add(&compare->n, n);
+	atomic_fetch_add(&compare->n_common, n_common);
+
+	return thrd_success;
+}
+
+/**
+ * @brief Collect the positions of a base file.
+ *
+ * The games are streamed from the file by chunks, each chunk being replayed
+ * by several threads.
+ *
+ * @param file Game base filename.
+ * @param set Position set of the base.
+ * @param other Position set of another base, or NULL.
+ * @param n_common Number of positions also in the other base (output).
+ * @return The number of different positions of the base.
+ */
+static int64_t base_compare_collect(const char *file, PositionSet *set, const PositionSet *other, int64_t *n_common)
+{
+	BaseCompare compare = {.set = set, .other = other};
+	BaseReader reader;
+	Base chunk;
+	const Game *game;
+	thrd_t thread[MAX_THREADS];
+	int t, n_threads;
+
+	atomic_init(&compare.n, 0);
+	atomic_init(&compare.n_common, 0);
+	if (base_reader_open(&reader, file)) {
+		base_init(&chunk);
+		compare.base = &chunk;
+		do {
+			chunk.n_games = 0;
+			while (chunk.n_games < BASE_ANALYSIS_CHUNK && (game = base_reader_next(&reader)) != NULL) {
+				base_append(&chunk, game);
+			}
+			n_threads = MIN(options.n_task, (chunk.n_games + BASE_COMPARE_CHUNK - 1) / BASE_COMPARE_CHUNK);
+			atomic_init(&compare.i, 0);
+			for (t = 1; t < n_threads; ++t) thrd_create(thread + t, base_compare_thread, &compare);
+			base_compare_thread(&compare);
+			for (t = 1; t < n_threads; ++t) thrd_join(thread[t], NULL);
+		} while (chunk.n_games == BASE_ANALYSIS_CHUNK);
+		base_free(&chunk);
+		base_reader_close(&reader);
+	}
+
+	*n_common = atomic_load(&compare.n_common);
+	return atomic_load(&compare.n);
+}
+
+/**
+ * @brief Compare the positions of two bases.
+ *
+ * The positions of the first base are collected, then those of the second
+ * base, looking them up among the first ones.
+ *
+ * @param file_1 First game base filename.
+ * @param file_2 Second game base filename.
+ */
+void base_compare(const char *file_1, const char *file_2)
+{
+	PositionSet *set_1, *set_2;
+	int64_t n_1, n_2, n_common;
+
+	set_1 = (PositionSet*) malloc(sizeof (PositionSet));
+	set_2 = (PositionSet*) malloc(sizeof (PositionSet));
+	if (set_1 == NULL || set_2 == NULL) fatal_error("Cannot allocate a position set.\n");
+	position_set_init(set_1);
+	position_set_init(set_2);
+
+	n_1 = base_compare_collect(file_1, set_1, NULL, &n_common);
+	n_2 = base_compare_collect(file_2, set_2, set_1, &n_common);
+
+	position_set_free(set_2);
+	position_set_free(set_1);
+	free(set_2);
+	free(set_1);
+
+	printf("%s : %" PRId64 " positions - %" PRId64 " original positions\n", file_1, n_1, n_1 - n_common);
+	printf("%s : %" PRId64 " positions - %" PRId64 " original positions\n", file_2, n_2, n_2 - n_common);
+	printf("%" PRId64 "common positions\n", n_common);
+}
+
+/**
+ * @brief Header of a base index file.
+ *
+ * The header is followed by the positions and the games through them.
+ */
+typedef struct BaseIndexHeader {
+	unsigned int edax;           /**< EDAX tag */
+	unsigned int index;          /**< BIDX tag */
+	unsigned char version;       /**< file version */
+	unsigned char release;       /**< file release */
+	int n_games;                 /**< number of games of the base */
+	uint64_t n_positions;        /**< number of positions */
+	uint64_t n_entries;          /**< number of games through all the positions */
+} BaseIndexHeader;
+
+/** A game through a position, while the index is built */
+typedef struct BaseIndexEntry {
+	Board board;                 /**< position, in its unique symetric form */
+	BaseIndexGame game;          /**< game through the position */
+} BaseIndexEntry;
+
+/** Base index under construction, shared by several threads */
+typedef struct BaseIndexBuild {
+	const Base *base;            /**< games of the current run */
+	int first;                   /**< rank of the first game of the run in the base file */
+	BaseIndexEntry *entry;       /**< positions of the games, 61 slots per game */
+	unsigned char *n_entries;    /**< number of positions per game */
+	BaseIndexEntry *sorted[2];   /**< source & destination of the sort */
+	int64_t bound[MAX_THREADS + 1]; /**< sorted parts */
+	int n_parts;                 /**< number of sorted parts */
+	int width;                   /**< number of parts already merged together (0 while sorting) */
+	_Atomic int i;               /**< next games or parts to process */
+} BaseIndexBuild;
+
+/**
+ * @brief Compare two entries by position, game & ply.
+ *
+ * @param a First entry.
+ * @param b Second entry.
+ * @return A negative, null or positive number.
+ */
+static int base_index_entry_cmp(const void *a, const void *b)
+{
+	const BaseIndexEntry *e = (const BaseIndexEntry*) a, *f = (const BaseIndexEntry*) b;
+
+	if (e->board.player != f->board.player) return e->board.player < f->board.player ? -1 : 1;
+	if (e->board.opponent != f->board.opponent) return e->board.opponent < f->board.opponent ? -1 : 1;
+	if (e->game.game != f->game.game) return e->game.game < f->game.game ? -1 : 1;
+	return e->game.ply - f->game.ply;
+}
+
+/**
+ * @brief List the positions of a game.
+ *
+ * @param game Game.
+ * @param id Game rank.
+ * @param entry Positions of the game (output, up to 61).
+ * @return The number of positions.
+ */
+static int base_index_game(const Game *game, const int id, BaseIndexEntry *entry)
+{
+	const int score = game_score(game);
+	Board board = game->initial_board;
+	int i, n = 0, player = game->player;
+
+	for (i = 0; ; ++i) {
+		memset(entry + n, 0, sizeof *entry); // no random padding in the index file
+		board_unique(&board, &entry[n].board);
+		entry[n].game.game = id;
+		entry[n].game.ply = i;
+		entry[n].game.score = (score == -SCORE_INF ? -SCORE_INF : (player == game->player ? score : -score));
+		++n;
+
+		if (i == 60 || game->move[i] == NOMOVE) break;
+		if (!can_move(board.player, board.opponent)) player ^= 1;
+		if (!game_update_board(&board, game->move[i])) break; // BAD MOVE -> end of game
+		player ^= 1;
+	}
+
+	return n;
+}
+
+/**
+ * @brief Index the positions of games, or sort parts of the index, until none is left.
+ *
+ * @param v Base index under construction (cast as void).
+ * @return thrd_success.
+ */
+static int base_index_thread(void *v)
+{
+	BaseIndexBuild *build = (BaseIndexBuild*) v;
+	const int64_t *bound = build->bound;
+	BaseIndexEntry *src = build->sorted[0], *dst = build->sorted[1];
+	int i, j, n, k, w = build->width;
+	int64_t l, m, r, o, end;
+
+	if (build->entry) {
+		while ((i = atomic_fetch_add(&build->i, BASE_INDEX_CHUNK)) < build->base->n_games) {
+			n = MIN(i + BASE_INDEX_CHUNK, build->base->n_games);
+			for (j = i; j < n; ++j) build->n_entries[j] = base_index_game(build->base->game + j, build->first + j, build->entry + 61 * (int64_t) j);
+		}
+	} else if (w == 0) {
+		while ((k = atomic_fetch_add(&build->i, 1)) < build->n_parts) {
+			qsort(src + bound[k], bound[k + 1] - bound[k], sizeof (BaseIndexEntry), base_index_entry_cmp);
+		}
+	} else {
+		while ((k = atomic_fetch_add(&build->i, 2 * w)) < build->n_parts) {
+			l = o = bound[k];
+			m = end = bound[MIN(k + w, build->n_parts)];
+			r = bound[MIN(k + 2 * w, build->n_parts)];
+			while (l < end && m < r) {
+				if (base_index_entry_cmp(src + m, src + l) < 0) dst[o++] = src[m++];
+				else dst[o++] = src[l++];
+			}
+			while (l < end) dst[o++] = src[l++];
+			while (m < r) dst[o++] = src[m++];
+		}
+	}
+
+	return thrd_success;
+}
+
+/**
+ * @brief Run the threads building a base index.
+ *
+ * @param build Base index under construction.
+ * @param n_threads Number of threads.
+ */
+static void base_index_run(BaseIndexBuild *build, const int n_threads)
+{
+	thrd_t thread[MAX_THREADS];
+	int t;
+
+	atomic_init(&build->i, 0);
+	for (t = 1; t < n_threads; ++t) thrd_create(thread + t, base_index_thread, build);
+	base_index_thread(build);
+	for (t = 1; t < n_threads; ++t) thrd_join(thread[t], NULL);
+}
+
+/**
+ * @brief Sort the positions of a run of games.
+ *
+ * The positions of the games are listed & sorted by several threads.
+ *
+ * @param build Base index under construction, with the games of the run.
+ * @param entry Storage for the positions, 61 slots per game.
+ * @param tmp Storage to sort the positions.
+ * @param n_threads Number of threads.
+ * @param n Number of positions (output).
+ * @return The sorted positions (entry or tmp).
+ */
+static BaseIndexEntry* base_index_sort(BaseIndexBuild *build, BaseIndexEntry *entry, BaseIndexEntry *tmp, const int n_threads, int64_t *n)
+{
+	const int n_games = build->base->n_games;
+	int k;
+
+	// list the positions of every game
+	build->entry = entry;
+	base_index_run(build, MIN(n_threads, (n_games + BASE_INDEX_CHUNK - 1) / BASE_INDEX_CHUNK));
+	build->entry = NULL;
+	for (k = 0, *n = 0; k < n_games; ++k) {
+		memmove(entry + *n, entry + 61 * (int64_t) k, build->n_entries[k] * sizeof (BaseIndexEntry));
+		*n += build->n_entries[k];
+	}
+
+	// sort the positions by parts, then merge the parts
+	build->n_parts = MIN(n_threads, MAX_THREADS);
+	for (k = 0; k <= build->n_parts; ++k) build->bound[k] = *n * k / build->n_parts;
+	build->sorted[0] = entry; build->sorted[1] = tmp;
+	build->width = 0;
+	base_index_run(build, build->n_parts);
+	for (build->width = 1; build->width < build->n_parts; build->width *= 2) {
+		base_index_run(build, (build->n_parts + 2 * build->width - 1) / (2 * build->width));
+		tmp = build->sorted[0]; build->sorted[0] = build->sorted[1]; build->sorted[1] = tmp;
+	}
+
+	return build->sorted[0];
+}
+
+/** A sorted run of positions, read back from its temporary file */
+typedef struct BaseIndexStream {
+	long offset;                 /**< file offset of the next positions to read */
+	long end;                    /**< file offset of the end of the run */
+	BaseIndexEntry *entry;       /**< positions read */
+	int n;                       /**< number of positions read */
+	int i;                       /**< next position */
+} BaseIndexStream;
+
+/**
+ * @brief Get the next position of a sorted run.
+ *
+ * @param stream Sorted run.
+ * @param f Temporary file of the runs.
+ * @param size Number of positions read at once.
+ * @return The next position, or NULL at the end of the run.
+ */
+static const BaseIndexEntry* base_index_stream_next(BaseIndexStream *stream, FILE *f, const int size)
+{
+	if (stream->i == stream->n) {
+		stream->n = (int) MIN(size, (stream->end - stream->offset) / (long) sizeof (BaseIndexEntry));
+		stream->i = 0;
+		if (stream->n == 0 || fseek(f, stream->offset, SEEK_SET) != 0 || fread(stream->entry, sizeof (BaseIndexEntry), stream->n, f) != (size_t) stream->n) {
+			stream->n = 0;
+			stream->offset = stream->end;
+			return NULL;
+		}
+		stream->offset += stream->n * (long) sizeof (BaseIndexEntry);
+	}
+	return stream->entry + stream->i;
+}
+
+/**
+ * @brief Restore the order of a heap of sorted runs, from its top.
+ *
+ * @param stream Sorted runs.
+ * @param heap Heap of runs, ordered by their next position.
+ * @param n Heap size.
+ */
+static void base_index_heap_down(const BaseIndexStream *stream, int *heap, const int n)
+{
+	int i = 0, j, top = heap[0];
+
+	while ((j = 2 * i + 1) < n) {
+		if (j + 1 < n && base_index_entry_cmp(stream[heap[j + 1]].entry + stream[heap[j + 1]].i, stream[heap[j]].entry + stream[heap[j]].i) < 0) ++j;
+		if (base_index_entry_cmp(stream[heap[j]].entry + stream[heap[j]].i, stream[top].entry + stream[top].i) >= 0) break;
+		heap[i] = heap[j];
+		i = j;
+	}
+	heap[i] = top;
+}
+
+/**
+ * @brief Merge the sorted runs of positions into the index file.
+ *
+ * The positions are written to the index file, and the games through them to
+ * a temporary file, appended to the index file once every position is known.
+ *
+ * @param run Temporary file of the sorted runs.
+ * @param bound File offsets of the runs.
+ * @param n_runs Number of runs.
+ * @param f Index file, after its header.
+ * @param games Temporary file of the games through the positions.
+ * @param buffer Storage for the positions read from the runs.
+ * @param size Number of positions of the storage.
+ * @param header Index header, whose number of positions is computed.
+ * @return true in case of success.
+ */
+static bool base_index_merge(FILE *run, const long *bound, const int n_runs, FILE *f, FILE *games, BaseIndexEntry *buffer, const int64_t size, BaseIndexHeader *header)
+{
+	BaseIndexStream *stream = (BaseIndexStream*) malloc(n_runs * sizeof (BaseIndexStream) + 1);
+	int *heap = (int*) malloc(n_runs * sizeof (int) + 1);
+	BaseIndexPosition position;
+	const BaseIndexEntry *e;
+	const int n_buffer = (int) MIN(size / MAX(n_runs, 1), INT_MAX);
+	int64_t i = 0;
+	int k, n = 0, score;
+	bool ok = (stream != NULL && heap != NULL);
+
+	if (!ok) error("cannot allocate memory to merge the index");
+
+	for (k = 0; ok && k < n_runs; ++k) {
+		stream[k].offset = bound[k];
+		stream[k].end = bound[k + 1];
+		stream[k].entry = buffer + k * (int64_t) n_buffer;
+		stream[k].n = stream[k].i = 0;
+		if (base_index_stream_next(stream + k, run, n_buffer)) heap[n++] = k;
+	}
+	for (k = 1; k < n; ++k) {
+		int j = k, x = heap[k];
+		while (j > 0 && base_index_entry_cmp(stream[x].entry + stream[x].i, stream[heap[(j - 1) / 2]].entry + stream[heap[(j - 1) / 2]].i) < 0) {
+			heap[j] = heap[(j - 1) / 2];
+			j = (j - 1) / 2;
 		}
+		heap[j] = x;
 	}
-	base_free(&base_2);
 
-	positionhash_delete(&hash);
+	memset(&position, 0, sizeof position);
+	while (ok && n > 0) {
+		k = heap[0];
+		e = stream[k].entry + stream[k].i;
+		if (i == 0 || !board_equal(&e->board, &position.board)) {
+			if (i > 0) ok = (fwrite(&position, sizeof position, 1, f) == 1);
+			memset(&position, 0, sizeof position);
+			position.board = e->board;
+			position.first = i;
+			++header->n_positions;
+		}
+		score = e->game.score;
+		++position.n_games;
+		if (score != -SCORE_INF) {
+			if (score > 0) ++position.n_wins;
+			else if (score < 0) ++position.n_losses;
+			else ++position.n_draws;
+		}
+		ok = ok && (fwrite(&e->game, sizeof (BaseIndexGame), 1, games) == 1);
+		++i;
+
+		++stream[k].i;
+		if (base_index_stream_next(stream + k, run, n_buffer) == NULL) heap[0] = heap[--n];
+		if (n > 1) base_index_heap_down(stream, heap, n);
+	}
+	if (ok && i > 0) ok = (fwrite(&position, sizeof position, 1, f) == 1);
+	ok = ok && ((uint64_t) i == header->n_entries);
+
+	free(heap);
+	free(stream);
+
+	return ok;
+}
+/**
+ * @brief Build the position index of a game base file.
+ *
+ * The games are read by runs of BASE_INDEX_RUN games, whose positions are
+ * listed & sorted by several threads into a temporary file. The sorted runs
+ * are then merged into the positions, followed by the games through them &
+ * their results, so that the memory used does not grow with the base size.
+ *
+ * @param file Game base filename.
+ * @param index_file Index filename.
+ * @return true in case of success.
+ */
+bool base_index_build(const char *file, const char *index_file)
+{
+	BaseIndexBuild build = {.base = NULL};
+	BaseIndexHeader header;
+	BaseIndexEntry *entry, *tmp, *sorted;
+	BaseReader reader;
+	Base base;
+	const Game *game;
+	FILE *f = NULL, *run = NULL, *games = NULL;
+	char run_file[FILENAME_MAX + 1], games_file[FILENAME_MAX + 1];
+	long *bound = NULL, *ptr;
+	const int n_threads = MAX(1, options.n_task);
+	const int64_t size = 61 * (int64_t) BASE_INDEX_RUN;
+	int64_t n;
+	size_t r;
+	int n_runs = 0, max_runs = 0;
+	bool ok;
+
+	if (!base_reader_open(&reader, file)) return false;
+
+	memset(&header, 0, sizeof header);
+	header.edax = EDAX;
+	header.index = BIDX;
+	header.version = VERSION;
+	header.release = RELEASE;
+
+	file_add_ext(index_file, ".run", run_file);
+	file_add_ext(index_file, ".gms", games_file);
+
+	// sort the positions by runs of games
+	base_init(&base);
+	entry = (BaseIndexEntry*) malloc(size * sizeof (BaseIndexEntry));
+	tmp = (BaseIndexEntry*) malloc(size * sizeof (BaseIndexEntry));
+	build.n_entries = (unsigned char*) malloc(BASE_INDEX_RUN);
+	ok = (entry != NULL && tmp != NULL && build.n_entries != NULL);
+	if (!ok) error("cannot allocate memory to index the base");
+	else if ((run = fopen(run_file, "w+b")) == NULL) {
+		warn("Cannot open file %s\n", run_file);
+		ok = false;
+	}
+
+	while (ok) {
+		base.n_games = 0;
+		while (base.n_games < BASE_INDEX_RUN && (game = base_reader_next(&reader)) != NULL) base_append(&base, game);
+		if (base.n_games == 0) break;
+
+		if (n_runs + 1 >= max_runs) {
+			max_runs = MAX(16, 2 * max_runs);
+			ptr = (long*) realloc(bound, max_runs * sizeof (long));
+			if (ptr == NULL) {
+				error("cannot reallocate index runs");
+				ok = false;
+				break;
+			}
+			bound = ptr;
+		}
+		if (n_runs == 0) bound[0] = 0;
+
+		build.base = &base;
+		build.first = header.n_games;
+		sorted = base_index_sort(&build, entry, tmp, n_threads, &n);
+		ok = (fwrite(sorted, sizeof (BaseIndexEntry), n, run) == (size_t) n);
+		bound[n_runs + 1] = bound[n_runs] + n * (long) sizeof (BaseIndexEntry);
+		++n_runs;
+		header.n_games += base.n_games;
+		header.n_entries += n;
+	}
+	base_reader_close(&reader);
+	base_free(&base);
+	free(build.n_entries);
+	free(tmp);
+	if (!ok) warn("Error while writing %s\n", run_file);
+	ok = ok && header.n_games > 0;
+
+	// merge the runs into the positions & their games
+	if (ok) {
+		f = fopen(index_file, "wb");
+		if (f == NULL) warn("Cannot open file %s\n", index_file);
+		games = fopen(games_file, "w+b");
+		if (games == NULL) warn("Cannot open file %s\n", games_file);
+		ok = (f != NULL && games != NULL);
+	}
+	if (ok) {
+		ok = (fwrite(&header, sizeof header, 1, f) == 1)
+		  && base_index_merge(run, bound, n_runs, f, games, entry, size, &header);
+		rewind(games);
+		while (ok && (r = fread(entry, 1, size * sizeof (BaseIndexEntry), games)) > 0) ok = (fwrite(entry, 1, r, f) == r);
+		ok = ok && !ferror(games) && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof header, 1, f) == 1;
+		ok = ok && !ferror(f);
+		if (!ok) warn("Error while writing %s\n", index_file);
+		else info("<%s: %" PRIu64 " positions from %d games indexed>\n", index_file, header.n_positions, header.n_games);
+	}
+
+	if (f) fclose(f);
+	if (games) fclose(games);
+	if (run) fclose(run);
+	remove(games_file);
+	remove(run_file);
+	free(entry);
+	free(bound);
+
+	return ok;
+}
+
+/**
+ * @brief Open a base index from its mapped file.
+ *
+ * @param index Base index.
+ * @param file Index filename.
+ * @return true in case of success.
+ */
+bool base_index_open(BaseIndex *index, const char *file)
+{
+	const BaseIndexHeader *header;
+	uint64_t size;
+
+	memset(index, 0, sizeof *index);
+	if ((index->address = file_map(file, &index->size)) == NULL) {
+		error("cannot map %s", file);
+		return false;
+	}
+
+	header = (const BaseIndexHeader*) index->address;
+	if (index->size < sizeof (BaseIndexHeader) || header->edax != EDAX || header->index != BIDX || header->version != VERSION) {
+		error("%s is not a compatible edax base index", file);
+	} else {
+		size = sizeof (BaseIndexHeader) + header->n_positions * sizeof (BaseIndexPosition) + header->n_entries * sizeof (BaseIndexGame);
+		if (size > index->size) {
+			error("%s is a truncated edax base index", file);
+		} else {
+			index->position = (const BaseIndexPosition*) (header + 1);
+			index->game = (const BaseIndexGame*) (index->position + header->n_positions);
+			index->n_positions = header->n_positions;
+			index->n_entries = header->n_entries;
+			index->n_games = header->n_games;
+			return true;
+		}
+	}
+
+	base_index_close(index);
+	return false;
+}
+
+/**
+ * @brief Close a base index.
+ *
+ * @param index Base index.
+ */
+void base_index_close(BaseIndex *index)
+{
+	file_unmap(index->address, index->size);
+	memset(index, 0, sizeof *index);
+}
+
+/**
+ * @brief Find a position in a base index.
+ *
+ * @param index Base index.
+ * @param board Position.
+ * @return The indexed position, or NULL if no game goes through it.
+ */
+const BaseIndexPosition* base_index_find(const BaseIndex *index, const Board *board)
+{
+	Board unique;
+	uint64_t l = 0, r = index->n_positions, m;
+
+	board_unique(board, &unique);
+	while (l < r) {
+		m = (l + r) / 2;
+		if (board_lesser(&index->position[m].board, &unique)) l = m + 1;
+		else r = m;
+	}
+	if (l < index->n_positions && board_equal(&index->position[l].board, &unique)) return index->position + l;
+
+	return NULL;
+}
+
+/**
+ * @brief Print the games of a base index going through a position.
+ *
+ * @param index Base index.
+ * @param board Position.
+ * @param n_max Maximal number of games to print.
+ * @param f Output stream.
+ */
+void base_index_print(const BaseIndex *index, const Board *board, const int n_max, FILE *f)
+{
+	const BaseIndexPosition *position = base_index_find(index, board);
+	const BaseIndexGame *game;
+	int i;
 
-	printf("%s : %" PRId64 " positions - %" PRId64 " original positions\n", file_1, n_1, n_1 - (n_2- n_2_only));
-	printf("%s : %" PRId64 " positions - %" PRId64 " original positions\n", file_2, n_2, n_2_only);
-	printf("%" PRId64 "common positions\n", n_2-n_2_only);
+	if (position == NULL) {
+		fprintf(f, "no game through this position.\n");
+		return;
+	}
+
+	fprintf(f, "%d games through this position: %d wins, %d draws, %d losses for the player to move.\n",
+		position->n_games, position->n_wins, position->n_draws, position->n_losses);
+	for (i = 0; i < position->n_games && i < n_max; ++i) {
+		game = index->game + position->first + i;
+		fprintf(f, "  game #%d, ply %d", game->game, game->ply);
+		if (game->score != -SCORE_INF) fprintf(f, ", score %+d", game->score);
+		putc('\n', f);
+	}
+	if (position->n_games > n_max) fprintf(f, "  ...\n");
 }
@@ -13,6 +13,7 @@
 
 #include "game.h"
 #include <stdbool.h>
+#include <stdio.h>
 
 /* structures */
 struct Search;
@@ -51,6 +52,80 @@ typedef struct Base {
 	int size;
 } Base;
 
+/**
+ * struct BaseReader
+ * @brief Streaming reader over the games of a base file.
+ *
+ * Files are read from a memory map. Text files are split into chunks at game
+ * boundaries, parsed by several threads.
+ */
+typedef struct BaseReader {
+	void (*load)(Game*, GameSource*); /**< game parser (text formats) */
+	unsigned char *map;           /**< mapped file */
+	size_t size;                  /**< mapped file size */
+	size_t offset;                /**< offset of the next record, or of the text left to parse */
+	size_t record_size;           /**< record size (0 for text formats) */
+	struct BaseTextChunk *chunk;  /**< chunks of parsed games (text formats) */
+	int max_chunks;               /**< number of chunks parsed at once (text formats) */
+	int n_chunks;                 /**< number of parsed chunks (text formats) */
+	int i_chunk;                  /**< current chunk (text formats) */
+	int i_game;                   /**< next game in the current chunk (text formats) */
+	WthorHeader header;           /**< header (wthor format) */
+	const WthorGame *wthor;       /**< last wthor record read (wthor format) */
+	Game game;                    /**< last game read (wthor format) */
+	int n_games;                  /**< number of games in the file (or -1 if unknown) */
+	int i;                        /**< number of games read */
+} BaseReader;
+
+/**
+ * struct BaseWriter
+ * @brief Streaming writer, appending games to a base file.
+ */
+typedef struct BaseWriter {
+	void (*save)(const Game*, FILE*); /**< game writer (other formats than wthor) */
+	FILE *f;                      /**< opened file */
+	WthorBase wthor;              /**< header & players (wthor format) */
+	char path[FILENAME_MAX];      /**< player file (wthor format) */
+	int n_games;                  /**< number of games written (& already in a wthor file) */
+} BaseWriter;
+
+/**
+ * struct BaseIndexPosition
+ * @brief A position of a base index, with the results of the games through it.
+ */
+typedef struct BaseIndexPosition {
+	Board board;                  /**< position, in its unique symetric form */
+	uint64_t first;               /**< first of its games in the index */
+	int n_games;                  /**< number of games through the position */
+	int n_wins;                   /**< number of games won by the player to move */
+	int n_draws;                  /**< number of drawn games */
+	int n_losses;                 /**< number of games lost by the player to move */
+} BaseIndexPosition;
+
+/**
+ * struct BaseIndexGame
+ * @brief A game through a position of a base index.
+ */
+typedef struct BaseIndexGame {
+	int game;                     /**< game rank in the base file */
+	unsigned char ply;            /**< ply of the position in the game */
+	signed char score;            /**< final score for the player to move (-SCORE_INF if unfinished) */
+} BaseIndexGame;
+
+/**
+ * struct BaseIndex
+ * @brief Index of the positions of a game base, used from its mapped file.
+ */
+typedef struct BaseIndex {
+	void *address;                /**< mapped file */
+	size_t size;                  /**< mapped size */
+	const BaseIndexPosition *position; /**< positions, sorted */
+	const BaseIndexGame *game;    /**< games through the positions */
+	uint64_t n_positions;         /**< number of positions */
+	uint64_t n_entries;           /**< number of games through all the positions */
+	int n_games;                  /**< number of games of the base */
+} BaseIndex;
+
 /* function declarations */
 void wthor_init(WthorBase*);
 bool wthor_load(WthorBase*, const char*);
@@ -62,17 +137,34 @@ void wthor_edaxify(const char*);
 #define foreach_wthorgame(wgame, wbase) \
 	for ((wgame) = (wbase).game ; (wgame) < (wbase).game + (wbase).header.n_games; ++(wgame))
 
+bool base_reader_open(BaseReader*, const char*);
+const Game* base_reader_next(BaseReader*);
+void base_reader_close(BaseReader*);
+bool base_writer_open(BaseWriter*, const char*);
+void base_writer_write(BaseWriter*, const Game*);
+void base_writer_close(BaseWriter*);
+
+#define foreach_base_game(game, reader) \
+	for ((game) = base_reader_next(&(reader)); (game) != NULL; (game) = base_reader_next(&(reader)))
+
 void base_init(Base*);
 void base_free(Base*);
 bool base_load(Base*, const char*);
 void base_save(const Base*, const char*);
+bool base_convert(const char*, const char*);
 void base_append(Base*, const Game*);
-void base_to_problem(Base*, const int, const char*);
-void base_to_FEN(Base*, const int, const char*);
+void base_to_problem(const char*, const int, const char*);
+void base_to_FEN(const char*, const int, const char*);
 void base_analyze(Base*, struct Search*, const int, const bool);
+void base_check(const char*, struct Search*, const int);
 void base_complete(Base*, struct Search*);
-void base_unique(Base*);
+void base_unique(Base*, const bool);
 void base_compare(const char*, const char*);
+bool base_index_build(const char*, const char*);
+bool base_index_open(BaseIndex*, const char*);
+void base_index_close(BaseIndex*);
+const BaseIndexPosition* base_index_find(const BaseIndex*, const Board*);
+void base_index_print(const BaseIndex*, const Board*, const int, FILE*);
 
 #endif /* EDAX_BASE_H */
 
@@ -20,6 +20,7 @@
 #include "search.h"
 #include "const.h"
 #include "bit.h"
+#include "crc32c.h"
 #include "options.h"
 #include "util.h"
 
@@ -33,6 +34,16 @@
 #include <time.h>
 
 #define BOOK_DEBUG 0
+
+/** period between two saves of the book modifications during long computations */
+#define BOOK_CHECKPOINT_PERIOD (HOUR / 6)
+
+/** number of positions exported at once */
+#define BOOK_EXPORT_CHUNK 4096
+
+/** number of games whose positions are gathered at once */
+#define BOOK_IMPORT_CHUNK 16384
+
 static const int BOOK_INFO_RESOLUTION = 100000;
 
 #define clear_line() bprint("                                                                                \r")
@@ -114,11 +125,14 @@ typedef struct Position {
 	unsigned char level;       /**< search level */
 	unsigned char done;        /**< done/undone flag */
 	unsigned char todo;        /**< todo flag */
+	uint32_t checksum;         /**< checksum when last saved (0 if never saved) */
 } Position;
 
 static Position* book_probe(const Book*, const Board*);
+static const Position* book_view(const Book*, const Board*, Position*);
 static void book_add(Book*, const Position*);
 static void position_print(const Position*, const Board*, FILE*);
+static void book_replay(Book*, const char*);
 
 #define foreach_link(l, p)  \
 	for ((l) = (p)->link; (l) < (p)->link + (p)->n_link; ++(l))
@@ -147,9 +161,10 @@ static int get_book_depth(const int depth)
  * Note: All positions should always be OK! A wrong position means a BUG!
  *
  * @param position Position.
+ * @param verbose Print what is wrong.
  * @return true if ok, false if it needs fixing.
  */
-static bool position_is_ok(const Position *position)
+static bool position_check(const Position *position, const bool verbose)
 {
 	Board board;
 	Move move;
@@ -159,21 +174,27 @@ static bool position_is_ok(const Position *position)
 
 	// board is legal ?
 	if (position->board.player & position->board.opponent) {
-		warn("Board is illegal: Two discs on the same square?\n");
-		board_print(&position->board, BLACK, stderr);
+		if (verbose) {
+			warn("Board is illegal: Two discs on the same square?\n");
+			board_print(&position->board, BLACK, stderr);
+		}
 		return false;
 	}
 	if (((position->board.player | position->board.opponent) & 0x0000001818000000ULL) != 0x0000001818000000ULL) {
-		warn("Board is illegal: Empty center?\n");
-		board_print(&position->board, BLACK, stderr);
+		if (verbose) {
+			warn("Board is illegal: Empty center?\n");
+			board_print(&position->board, BLACK, stderr);
+		}
 		return false;
 	}
 
 	// is board unique
 	board_unique(&position->board, &board);
 	if (!board_equal(&position->board, &board)) {
-		warn("board is not unique\n");
-		position_print(position, &position->board, stdout);
+		if (verbose) {
+			warn("board is not unique\n");
+			position_print(position, &position->board, stdout);
+		}
 		return false;
 	}
 
@@ -183,16 +204,20 @@ static bool position_is_ok(const Position *position)
 			if (position->n_link > 1
 			 || can_move(board.player, board.opponent)
 			 || !can_move(board.opponent, board.player)) {
-				warn("passing move is wrong\n");
-				position_print(position, &position->board, stdout);
+				if (verbose) {
+					warn("passing move is wrong\n");
+					position_print(position, &position->board, stdout);
+				}
 				return false;
 			}
 		} else {
 			if (/*l->move < A1 ||*/ l->move > H8
 			 || board_is_occupied(&board, l->move)
 			 || board_get_move(&board, l->move, &move) == 0) {
-				warn("link %s is wrong\n", move_to_string(l->move, WHITE, s));
-				position_print(position, &position->board, stdout);
+				if (verbose) {
+					warn("link %s is wrong\n", move_to_string(l->move, WHITE, s));
+					position_print(position, &position->board, stdout);
+				}
 				return false;
 			}
 		}
@@ -203,21 +228,27 @@ static bool position_is_ok(const Position *position)
 		if (position->n_link > 0
 		 || can_move(board.player, board.opponent)
 		 || !can_move(board.opponent, board.player)) {
-			warn("passing move is wrong\n");
-			position_print(position, &position->board, stdout);
+			if (verbose) {
+				warn("passing move is wrong\n");
+				position_print(position, &position->board, stdout);
+			}
 			return false;
 		}
 	} else if (l->move == NOMOVE) {
 		if (get_mobility(position->board.player, position->board.opponent) != position->n_link && !(position->n_link == 1 && position->link->move == PASS)) {
-			warn("nomove is wrong\n");
-			position_print(position, &position->board, stdout);
+			if (verbose) {
+				warn("nomove is wrong\n");
+				position_print(position, &position->board, stdout);
+			}
 			return false;
 		}
 	} else if (/*l->move < A1 ||*/ l->move > H8
 		 || board_is_occupied(&board, l->move)
 		 || board_get_move(&board, l->move, &move) == 0) {
-			warn("leaf %s is wrong\n", move_to_string(l->move, WHITE, s));
-			position_print(position, &position->board, stdout);
+			if (verbose) {
+				warn("leaf %s is wrong\n", move_to_string(l->move, WHITE, s));
+				position_print(position, &position->board, stdout);
+			}
 			return false;
 	}
 
@@ -225,20 +256,35 @@ static bool position_is_ok(const Position *position)
 	for (i = 0; i < position->n_link; ++i) {
 		for (j = i + 1; j < position->n_link; ++j) {
 			if (position->link[j].move == position->link[i].move) {
-				warn("doublon found in links\n");
-				position_print(position, &position->board, stdout);
+				if (verbose) {
+					warn("doublon found in links\n");
+					position_print(position, &position->board, stdout);
+				}
 				return false;
 			}
 		}
 		if (position->leaf.move == position->link[i].move) {
-			warn("doublon found in links/leaf\n");
-			position_print(position, &position->board, stdout);
+			if (verbose) {
+				warn("doublon found in links/leaf\n");
+				position_print(position, &position->board, stdout);
+			}
 			return false;
 		}
 	}
 	return true;
 }
 
+/**
+ * @brief Check if position is ok or need fixing, printing what is wrong.
+ *
+ * @param position Position.
+ * @return true if ok, false if it needs fixing.
+ */
+static bool position_is_ok(const Position *position)
+{
+	return position_check(position, true);
+}
+
 /**
  * @brief Initialize a position.
  *
@@ -259,6 +305,7 @@ static void position_init(Position *position)
 	position->level = 0;
 	position->done = true;
 	position->todo = false;
+	position->checksum = 0;
 }
 
 /**
@@ -291,23 +338,150 @@ static void position_merge(Position *dest, const Position *src)
 	}
 }
 
+/** number of link block sizes (4, 8, 16, 32 & 64 links) */
+#define LINK_N_CLASSES 5
+
+/** size of the memory chunks storing the links */
+#define LINK_CHUNK_SIZE (1 << 20)
+
+/**
+ * @brief Get the size class of a block of links.
+ *
+ * @param n Number of links.
+ * @return The smallest class with room for the links.
+ */
+static int link_class(const int n)
+{
+	int c = 0;
+
+	while ((4 << c) < n) ++c;
+	return c;
+}
+
+/**
+ * @brief Initialize the link storage.
+ *
+ * @param arena Link storage.
+ */
+static void link_arena_init(LinkArena *arena)
+{
+	int c;
+
+	arena->chunk = NULL;
+	arena->n_chunks = 0;
+	arena->top = arena->end = NULL;
+	for (c = 0; c < LINK_N_CLASSES; ++c) arena->free[c] = NULL;
+	spinlock_init(&arena->lock);
+}
+
+/**
+ * @brief Free the link storage, and all the links stored in it.
+ *
+ * @param arena Link storage.
+ */
+static void link_arena_free(LinkArena *arena)
+{
+	int i;
+
+	for (i = 0; i < arena->n_chunks; ++i) free(arena->chunk[i]);
+	free(arena->chunk);
+	link_arena_init(arena);
+}
+
+/**
+ * @brief Allocate a block of links.
+ *
+ * The block comes from the blocks freed with the same size class, or from the
+ * last memory chunk.
+ *
+ * @param arena Link storage.
+ * @param n Number of links.
+ * @return The block, or NULL if no memory is available.
+ */
+static Link* link_alloc(LinkArena *arena, const int n)
+{
+	const int c = link_class(n);
+	const size_t size = (4 << c) * sizeof (Link);
+	Link *l = NULL;
+
+	assert(c < LINK_N_CLASSES);
+
+	spinlock_lock(&arena->lock);
+	if (arena->free[c]) {
+		l = (Link*) arena->free[c];
+		memcpy(&arena->free[c], l, sizeof (void*));
+	} else {
+		if ((size_t) (arena->end - arena->top) < size) {
+			char **chunk = (char**) realloc(arena->chunk, (arena->n_chunks + 1) * sizeof (char*));
+			if (chunk) {
+				arena->chunk = chunk;
+				arena->top = (char*) malloc(LINK_CHUNK_SIZE);
+				arena->end = arena->top ? arena->top + LINK_CHUNK_SIZE : NULL;
+				if (arena->top) arena->chunk[arena->n_chunks++] = arena->top;
+			}
+		}
+		if (arena->top) {
+			l = (Link*) arena->top;
+			arena->top += size;
+		}
+	}
+	spinlock_unlock(&arena->lock);
+
+	return l;
+}
+
+/**
+ * @brief Free a block of links, to be reused.
+ *
+ * @param arena Link storage.
+ * @param l Block.
+ * @param n Number of links in the block.
+ */
+static void link_release(LinkArena *arena, Link *l, const int n)
+{
+	const int c = link_class(n);
+
+	if (l == NULL || n == 0) return;
+
+	spinlock_lock(&arena->lock);
+	memcpy(l, &arena->free[c], sizeof (void*));
+	arena->free[c] = l;
+	spinlock_unlock(&arena->lock);
+}
+
+/**
+ * @brief Get the memory used by the link storage.
+ *
+ * @param arena Link storage.
+ * @return The size of the memory chunks.
+ */
+static size_t link_arena_size(const LinkArena *arena)
+{
+	return (size_t) arena->n_chunks * LINK_CHUNK_SIZE + arena->n_chunks * sizeof (char*);
+}
+
 /**
  * @brief Free resources used by a position.
  *
  * @param position Position.
+ * @param arena Link storage.
  */
-static void position_free(Position *position)
+static void position_free(Position *position, LinkArena *arena)
 {
-	free(position->link);
+	link_release(arena, position->link, position->n_link);
 }
 
 /**
  * @brief Read a position.
  *
+ * On failure, the links already read are kept in the position, to be released
+ * with position_free().
+ *
  * @param position Position to read in.
  * @param f Input stream.
+ * @param arena Link storage.
  */
-static bool position_read(Position *position, FILE *f)
+static bool position_read(Position *position, FILE *f, LinkArena *arena)
 {
 	int i;
 	int r;
@@ -327,13 +501,18 @@ static bool position_read(Position *position, FILE *f)
 	r += fread(&position->n_link, 1, 1, f);
 	r += fread(&position->level, 1, 1, f);
 
-	if (r != 11) return false;
+	if (r != 11) {
+		position->link = NULL;
+		position->n_link = 0;
+		return false;
+	}
 
 	position->done = position->todo = false;
+	position->checksum = 0;
 
 	if (position->n_link) {
-		position->link = (Link*) malloc(sizeof (Link) * position->n_link);
-		if (position->link == NULL) error("cannot allocate opening book position's moves\n");
+		position->link = link_alloc(arena, position->n_link);
+		if (position->link == NULL) fatal_error("cannot allocate opening book position's moves\n");
 		for (i = 0; i < position->n_link; ++i) {
 			if (!link_read(position->link + i, f)) return false;
 		}
@@ -434,6 +613,35 @@ static bool position_write(const Position *position, FILE* f)
 	return true;
 }
 
+/**
+ * @brief Compute the checksum of the saved content of a position.
+ *
+ * @param position Position.
+ * @return The checksum (never 0).
+ */
+static uint32_t position_checksum(const Position *position)
+{
+	uint32_t crc;
+	int i;
+
+	crc = crc32c_u64(0, position->board.player);
+	crc = crc32c_u64(crc, position->board.opponent);
+	crc = crc32c_u64(crc, ((uint64_t) position->n_wins << 32) | position->n_draws);
+	crc = crc32c_u64(crc, ((uint64_t) position->n_losses << 32) | position->n_lines);
+	crc = crc32c_u64(crc, (uint64_t) (unsigned short) position->score.value
+		| (uint64_t) (unsigned short) position->score.lower << 16
+		| (uint64_t) (unsigned short) position->score.upper << 32
+		| (uint64_t) position->n_link << 48 | (uint64_t) position->level << 56);
+	for (i = 0; i < position->n_link; ++i) {
+		crc = crc32c_u8(crc, (unsigned char) position->link[i].score);
+		crc = crc32c_u8(crc, position->link[i].move);
+	}
+	crc = crc32c_u8(crc, (unsigned char) position->leaf.score);
+	crc = crc32c_u8(crc, position->leaf.move);
+
+	return crc | 1;
+}
+
 /**
  * @brief write a position.
  *
@@ -618,9 +826,10 @@ static void position_get_random_move(const Position *position, const Board *boar
  *
  * @param position Position to chose a move from.
  * @param link Link to add.
+ * @param arena Link storage.
  * @return true if the link has been added, false if it was already present.
  */
-static bool position_add_link(Position *position, const Link *link)
+static bool position_add_link(Position *position, const Link *link, LinkArena *arena)
 {
 	Link *l;
 	int last = position->n_link;
@@ -632,14 +841,18 @@ static bool position_add_link(Position *position, const Link *link)
 		}
 	}
 
-	l = (Link*) realloc(position->link, sizeof (Link) * (++position->n_link));
-	if (l == NULL) {
-		--position->n_link;
-		error("cannot allocate opening book position's moves\n");
-		return false;
+	if (last == 0 || link_class(last + 1) != link_class(last)) {
+		l = link_alloc(arena, last + 1);
+		if (l == NULL) {
+			error("cannot allocate opening book position's moves\n");
+			return false;
+		}
+		if (last) memcpy(l, position->link, last * sizeof (Link));
+		link_release(arena, position->link, last);
+		position->link = l;
 	}
-	position->link = l;
 	position->link[last] = *link;
+	++position->n_link;
 
 	if (link->score > position->score.value) position->score.value = link->score;
 
@@ -673,24 +886,27 @@ static void position_sort(Position *position)
 }
 
 /**
- * @brief Evaluate a position.
+ * @brief Evaluate a position with a search.
  *
  * If needed, find the best remaining move, after link moves are excluded.
  *
  * @param position Position to search.
- * @param book Opening book.
+ * @param arena Link storage.
+ * @param search Search.
+ * @param n_links Number of links added (output).
+ * @return true if the position changed.
  */
-static void position_search(Position *position, Book *book)
+static bool position_evaluate(Position *position, LinkArena *arena, Search *search, int *n_links)
 {
-	Search *search = book->search;
 	Link *l;
 	const int n_moves = get_mobility(position->board.player, position->board.opponent);
 	int64_t time;
 	bool time_per_move;
+	bool changed = false;
 
-	if (position->leaf.move != NOMOVE && position_add_link(position, &position->leaf)) {
-		book->need_saving = true;
-		++book->stats.n_links;
+	if (position->leaf.move != NOMOVE && position_add_link(position, &position->leaf, arena)) {
+		changed = true;
+		++(*n_links);
 	}
 
 	if (position->n_link < n_moves || (position->n_link == 0 && n_moves == 0 && position->score.value == -SCORE_INF)) {
@@ -722,8 +938,143 @@ static void position_search(Position *position, Book *book)
 		if (position->leaf.score > position->score.value) {
 			position->score.value = position->leaf.score;
 		}
-		book->need_saving = true;
+		changed = true;
+	}
+
+	return changed;
+}
+
+/**
+ * @brief Evaluate a position.
+ *
+ * If needed, find the best remaining move, after link moves are excluded.
+ *
+ * @param position Position to search.
+ * @param book Opening book.
+ */
+static void position_search(Position *position, Book *book)
+{
+	int n_links = 0;
+
+	if (position_evaluate(position, &book->arena, book->search, &n_links)) book->need_saving = true;
+	book->stats.n_links += n_links;
+}
+
+/**
+ * @brief Searches evaluating book positions simultaneously.
+ */
+typedef struct BookWorkers {
+	struct BookWorker *worker;   /**< workers */
+	int n;                       /**< number of workers */
+	Position **position;         /**< positions to evaluate */
+	LinkArena *arena;            /**< link storage of the positions */
+	int n_positions;             /**< number of positions to evaluate */
+	bool cleanup;                /**< clean up the search before each evaluation */
+	_Atomic int i;               /**< next position to evaluate */
+	_Atomic int n_links;         /**< number of links added */
+} BookWorkers;
+
+/**
+ * @brief A search evaluating book positions.
+ */
+typedef struct BookWorker {
+	Search search;               /**< search */
+	BookWorkers *workers;        /**< all the workers */
+	thrd_t thread;               /**< thread */
+} BookWorker;
+
+/**
+ * @brief Create the searches evaluating book positions simultaneously.
+ *
+ * options.n_batch searches share the tasks & the hash table memory.
+ *
+ * @param workers Workers.
+ * @return false if positions are evaluated one at a time, with the book search.
+ */
+static bool book_workers_init(BookWorkers *workers)
+{
+	int i;
+
+	workers->n = options.n_batch;
+	workers->worker = NULL;
+	if (workers->n <= 1) return false;
+
+	workers->worker = (BookWorker*) malloc(workers->n * sizeof (BookWorker));
+	if (workers->worker == NULL) {
+		warn("cannot allocate the book workers\n");
+		return false;
+	}
+	for (i = 0; i < workers->n; ++i) {
+		search_init_shared(&workers->worker[i].search, workers->n, i);
+		workers->worker[i].search.options.verbosity = 0;
+		workers->worker[i].workers = workers;
+	}
+	return true;
+}
+
+/**
+ * @brief Free the searches evaluating book positions.
+ *
+ * @param workers Workers.
+ */
+static void book_workers_free(BookWorkers *workers)
+{
+	int i;
+
+	if (workers->worker) {
+		for (i = 0; i < workers->n; ++i) search_free(&workers->worker[i].search);
+		free(workers->worker);
+	}
+}
+
+/**
+ * @brief Evaluate the next positions, until none is left.
+ *
+ * @param v Worker (cast as void).
+ * @return thrd_success.
+ */
+static int book_worker_run(void *v)
+{
+	BookWorker *worker = (BookWorker*) v;
+	BookWorkers *workers = worker->workers;
+	int i, n_links = 0;
+
+	while ((i = atomic_fetch_add(&workers->i, 1)) < workers->n_positions) {
+		if (workers->cleanup) search_cleanup(&worker->search);
+		position_evaluate(workers->position[i], workers->arena, &worker->search, &n_links);
 	}
+	atomic_fetch_add(&workers->n_links, n_links);
+
+	return thrd_success;
+}
+
+/**
+ * @brief Evaluate positions simultaneously.
+ *
+ * The positions must be distinct, and the book must not change meanwhile.
+ *
+ * @param book Opening book.
+ * @param workers Workers.
+ * @param position Positions to evaluate.
+ * @param n Number of positions to evaluate.
+ * @param cleanup Clean up the search before each evaluation.
+ */
+static void book_workers_evaluate(Book *book, BookWorkers *workers, Position **position, const int n, const bool cleanup)
+{
+	int i;
+
+	workers->position = position;
+	workers->arena = &book->arena;
+	workers->n_positions = n;
+	workers->cleanup = cleanup;
+	atomic_init(&workers->i, 0);
+	atomic_init(&workers->n_links, 0);
+
+	for (i = 0; i < workers->n; ++i) thrd_create(&workers->worker[i].thread, book_worker_run, workers->worker + i);
+	for (i = 0; i < workers->n; ++i) thrd_join(workers->worker[i].thread, NULL);
+
+	book->stats.n_links += atomic_load(&workers->n_links);
+	if (n > 0) book->need_saving = true;
 }
 
 /**
@@ -749,7 +1100,7 @@ static void position_link(Position *position, Book *book)
 			if (child) {
 				link.score = -child->score.value;
 				link.move = x;
-				book->stats.n_links += position_add_link(position, &link);
+				book->stats.n_links += position_add_link(position, &link, &book->arena);
 			}
 		}
 	} else if (can_move(position->board.opponent, position->board.player)) {// pass ?
@@ -759,7 +1110,7 @@ static void position_link(Position *position, Book *book)
 		if (child) {
 			link.score = -child->score.value;
 			link.move = PASS;
-			book->stats.n_links += position_add_link(position, &link);
+			book->stats.n_links += position_add_link(position, &link, &book->arena);
 		}
 	}
 }
@@ -794,6 +1145,72 @@ static void position_expand(Position *position, Book *book)
 	}
 }
 
+/**
+ * @brief Negamax a position from its child positions.
+ *
+ * The child positions must already be negamaxed.
+ *
+ * @param position Position to negamax.
+ * @param book Opening book.
+ * @return true if a link score changed.
+ */
+static bool position_negamax_update(Position *position, const Book *book)
+{
+	Link *l;
+	Board target;
+	const Position *child;
+	GameStats stat = {0,0,0,0};
+	const int n_empties = board_count_empties(&position->board);
+	const int search_depth = LEVEL[position->level][n_empties].depth;
+	const int bias = (search_depth & 1) - (n_empties & 1);
+	bool changed = false;
+
+	position->score.value = position->score.lower = position->score.upper = -SCORE_INF;
+
+	if (position->leaf.score > -SCORE_INF) {
+		position->score.value = position->leaf.score;
+		// is solving
+		if (search_depth == n_empties && LEVEL[position->level][n_empties].selectivity == NO_SELECTIVITY) {
+			position->score.lower = position->score.upper = position->score.value;
+			if (position->leaf.score > 0) ++stat.n_wins;
+			else if (position->leaf.score < 0) ++stat.n_losses;
+			else ++stat.n_draws;
+		// is pre-solving
+		} else if (search_depth == n_empties) {
+			position->score.lower = position->score.value - book->options.endcut_error;
+			position->score.upper = position->score.value + book->options.endcut_error;
+		} else { // midgame
+			position->score.lower = position->score.value - book->options.midgame_error - bias;
+			position->score.upper = position->score.value + book->options.midgame_error - bias;
+		}
+		++stat.n_lines;
+	}
+
+	foreach_link(l, position) {
+		board_next(&position->board, l->move, &target);
+		child = book_probe(book, &target);
+		if (l->score != -child->score.value) {
+			l->score = -child->score.value;
+			changed = true;
+		}
+		if (l->score > position->score.value) position->score.value = l->score;
+		if (-child->score.upper > position->score.lower) position->score.lower = -child->score.upper;
+		if (-child->score.lower > position->score.upper) position->score.upper = -child->score.lower;
+
+		stat.n_wins += child->n_losses;
+		stat.n_draws += child->n_draws;
+		stat.n_losses += child->n_wins;
+		stat.n_lines += child->n_lines;
+	}
+
+	position->n_wins = (unsigned int) MIN(UINT_MAX, stat.n_wins);
+	position->n_draws = (unsigned int) MIN(UINT_MAX, stat.n_draws);
+	position->n_losses = (unsigned int) MIN(UINT_MAX, stat.n_losses);
+	position->n_lines = (unsigned int) MIN(UINT_MAX, stat.n_lines);
+
+	return changed;
+}
+
 /**
  * @brief Negamax a position.
  *
@@ -806,59 +1223,15 @@ static int position_negamax(Position *position, Book *book)
 {
 	Link *l;
 	Board target;
-	Position *child;
 
 	if (!position->done) {
-		GameStats stat = {0,0,0,0};
-		const int n_empties = board_count_empties(&position->board);
-		const int search_depth = LEVEL[position->level][n_empties].depth;
-		const int bias = (search_depth & 1) - (n_empties & 1);
-
 		position->done = 1;
 
-		position->score.value = position->score.lower = position->score.upper = -SCORE_INF;
-
-		if (position->leaf.score > -SCORE_INF) {
-			position->score.value = position->leaf.score;
-			// is solving
-			if (search_depth == n_empties && LEVEL[position->level][n_empties].selectivity == NO_SELECTIVITY) {
-				position->score.lower = position->score.upper = position->score.value;
-				if (position->leaf.score > 0) ++stat.n_wins;
-				else if (position->leaf.score < 0) ++stat.n_losses;
-				else ++stat.n_draws;
-			// is pre-solving
-			} else if (search_depth == n_empties) {
-				position->score.lower = position->score.value - book->options.endcut_error;
-				position->score.upper = position->score.value + book->options.endcut_error;
-			} else { // midgame
-				position->score.lower = position->score.value - book->options.midgame_error - bias;
-				position->score.upper = position->score.value + book->options.midgame_error - bias;
-			}
-			++stat.n_lines;
-		}
-
 		foreach_link(l, position) {
 			board_next(&position->board, l->move, &target);
-			child = book_probe(book, &target);
-			position_negamax(child, book);
-			if (l->score != -child->score.value) {
-				l->score = -child->score.value;
-				book->need_saving = true;
-			}
-			if (l->score > position->score.value) position->score.value = l->score;
-			if (-child->score.upper > position->score.lower) position->score.lower = -child->score.upper;
-			if (-child->score.lower > position->score.upper) position->score.upper = -child->score.lower;
-
-			stat.n_wins += child->n_losses;
-			stat.n_draws += child->n_draws;
-			stat.n_losses += child->n_wins;
-			stat.n_lines += child->n_lines;
+			position_negamax(book_probe(book, &target), book);
 		}
-
-		position->n_wins = (unsigned int) MIN(UINT_MAX, stat.n_wins);
-		position->n_draws = (unsigned int) MIN(UINT_MAX, stat.n_draws);
-		position->n_losses = (unsigned int) MIN(UINT_MAX, stat.n_losses);
-		position->n_lines = (unsigned int) MIN(UINT_MAX, stat.n_lines);
+		if (position_negamax_update(position, book)) book->need_saving = true;
 	}
 
 	return position->score.value;
@@ -1094,42 +1467,108 @@ static void position_enhance(Position *position, Book *book)
 	}
 }
 
+/**
+ * @brief Set of the positions already fed into the hash tables.
+ */
+typedef struct FeedSet {
+	struct FeedSlot {
+		uint64_t hash_code;   /**< position hash code (0 = empty slot) */
+		int depth;            /**< remaining depth when fed */
+		bool is_pv;           /**< fed into the pv table */
+	} *slot;                  /**< open addressing table */
+	int size;                 /**< table size (power of 2) */
+	int n;                    /**< number of positions fed */
+	int n_max;                /**< maximal number of positions to feed */
+} FeedSet;
+
+/**
+ * @brief Find a position in the feed set, inserting it if absent.
+ *
+ * @param set Feed set.
+ * @param hash_code Position hash code.
+ * @return The position's slot, with a negative depth if newly inserted.
+ */
+static struct FeedSlot* feed_set_find(FeedSet *set, const uint64_t hash_code)
+{
+	struct FeedSlot *slot;
+	int i;
+
+	if (4 * (set->n + 1) > 3 * set->size) {
+		struct FeedSlot *old = set->slot;
+		const int old_size = set->size;
+
+		set->size = set->size ? 2 * set->size : 1024;
+		set->slot = (struct FeedSlot*) calloc(set->size, sizeof (struct FeedSlot));
+		if (set->slot == NULL) fatal_error("cannot allocate the feed set\n");
+		for (i = 0; i < old_size; ++i) if (old[i].hash_code) {
+			slot = set->slot + (old[i].hash_code & (set->size - 1));
+			while (slot->hash_code) if (++slot == set->slot + set->size) slot = set->slot;
+			*slot = old[i];
+		}
+		free(old);
+	}
+
+	slot = set->slot + ((hash_code | 1) & (set->size - 1));
+	while (slot->hash_code && slot->hash_code != (hash_code | 1)) if (++slot == set->slot + set->size) slot = set->slot;
+	if (slot->hash_code == 0) {
+		slot->hash_code = hash_code | 1;
+		slot->depth = -1;
+		++set->n;
+	}
+	return slot;
+}
+
 /**
  * @brief Feed hash from a position.
  *
  * Go through the book sub-tree following the current position & feed the hash table from this position.
+ * Each position is fed once, unless it is reached again with more depth left or from the principal variation.
  *
  * @param board Position to expand.
  * @param book Opening book.
  * @param search Hashtables container.
  * @param is_pv Flag to tell if the position is from the principal variation.
+ * @param depth Remaining depth to walk.
+ * @param set Positions already fed.
  */
-static void board_feed_hash(Board *board, const Book *book, Search *search, const bool is_pv)
+static void board_feed_hash(Board *board, const Book *book, Search *search, const bool is_pv, const int depth, FeedSet *set)
 {
-	Position *position;
+	const Position *position;
+	Position buffer;
 	const uint64_t hash_code = board_get_hash_code(board);
+	struct FeedSlot *slot;
 	MoveList movelist;
 	Move *m;
 
-	position = book_probe(book, board);
+	if (set->n >= set->n_max) return;
+
+	position = book_view(book, board, &buffer);
 	if (position) {
 		const int n_empties = board_count_empties(&position->board);
-		const int depth = LEVEL[position->level][n_empties].depth;
+		const int search_depth = LEVEL[position->level][n_empties].depth;
 		const int selectivity = LEVEL[position->level][n_empties].selectivity;
 		const int score = position->score.value;
 		int move = NOMOVE;
 
+		slot = feed_set_find(set, hash_code);
+		if (slot->depth >= depth && (slot->is_pv || !is_pv)) return;
+		slot->depth = depth;
+		slot->is_pv |= is_pv;
+		hash_prefetch(&search->hash_table, hash_code);
+
 		position_get_moves(position, board, &movelist);
 		foreach_move(m, &movelist) {
 			if (move == NOMOVE) move = m->x;
-			board_update(board, m);
-				board_feed_hash(board, book, search, is_pv && m->score == score);
-			board_restore(board, m);
+			if (depth > 0) {
+				board_update(board, m);
+					board_feed_hash(board, book, search, is_pv && m->score == score, depth - 1, set);
+				board_restore(board, m);
+			}
 		}
 	#ifdef __BIG_ENDIAN__
-		HashData data = {{{search->hash_table.date, 0, depth, selectivity}}, score, score, {move, 0}};
+		HashData data = {{{search->hash_table.date, 0, search_depth, selectivity}}, score, score, {move, 0}};
 	#else
-		HashData data = {{{selectivity, depth, 0, search->hash_table.date}}, score, score, {move, 0}};
+		HashData data = {{{selectivity, search_depth, 0, search->hash_table.date}}, score, score, {move, 0}};
 	#endif
 		hash_feed(&search->hash_table, board, hash_code, &data);
 		if (is_pv) hash_feed(&search->pv_table, board, hash_code, &data);
@@ -1137,35 +1576,81 @@ static void board_feed_hash(Board *board, const Book *book, Search *search, cons
 }
 
 /**
- * @brief Fill the opening book.
- *
- * Add positions to link existing positions.
+ * @brief Boards to add to the book.
+ */
+typedef struct BoardList {
+	Board *board;    /**< (unique) boards */
+	int n;           /**< number of boards */
+	int size;        /**< allocated size */
+} BoardList;
+
+/**
+ * @brief Check if a board is in a list.
  *
- * @param board Candidate position.
- * @param book Opening book.
- * @param depth Depth at which to search a link.
- * @return true if the board is in the book, possibly just after having been added to it.
+ * @param list Board list.
+ * @param board Board.
+ * @return true if the board, or a symetry, is in the list.
  */
-static bool board_fill(Board *board, Book *book, int depth)
+static bool board_list_contains(const BoardList *list, const Board *board)
 {
-	if (depth > 0) {
-		MoveList movelist;
-		Move *m;
-		bool filled = false;
+	Board unique;
+	int i;
 
-		movelist_get_moves(&movelist, board);
+	board_unique(board, &unique);
+	for (i = 0; i < list->n; ++i) if (board_equal(list->board + i, &unique)) return true;
+	return false;
+}
+
+/**
+ * @brief Add a board to a list, if not already there.
+ *
+ * @param list Board list.
+ * @param board Board.
+ */
+static void board_list_add(BoardList *list, const Board *board)
+{
+	if (board_list_contains(list, board)) return;
+	if (list->n == list->size) {
+		list->size += list->size / 2 + 64;
+		list->board = (Board*) realloc(list->board, list->size * sizeof (Board));
+		if (list->board == NULL) fatal_error("cannot allocate the boards to add to the book\n");
+	}
+	board_unique(board, list->board + list->n);
+	++list->n;
+}
+
+/**
+ * @brief Fill the opening book.
+ *
+ * Add positions to link existing positions.
+ * With a board list, the positions are collected into the list, to be added later.
+ *
+ * @param board Candidate position.
+ * @param book Opening book.
+ * @param depth Depth at which to search a link.
+ * @param list Boards to add (or NULL to add them immediately).
+ * @return true if the board is in the book, possibly just after having been added to it.
+ */
+static bool board_fill(Board *board, Book *book, int depth, BoardList *list)
+{
+	if (depth > 0) {
+		MoveList movelist;
+		Move *m;
+		bool filled = false;
+
+		movelist_get_moves(&movelist, board);
 		if (movelist.n_moves == 0 && can_move(board->opponent, board->player)) {
 			board_pass(board);
-			if (board_fill(board, book, depth - 1)) {
-				book_add_board(book, board);
+			if (board_fill(board, book, depth - 1, list)) {
+				if (list) board_list_add(list, board); else book_add_board(book, board);
 				filled = true;
 			}
 			board_pass(board);
 		} else {
 			foreach_move(m, &movelist) {
 				board_update(board, m);
-				if (board_fill(board, book, depth - 1)) {
-					book_add_board(book, board);
+				if (board_fill(board, book, depth - 1, list)) {
+					if (list) board_list_add(list, board); else book_add_board(book, board);
 					filled = true;
 				}
 				board_restore(board, m);
@@ -1173,7 +1658,68 @@ static bool board_fill(Board *board, Book *book, int depth)
 		}
 		return filled;
 	}
-	return book_probe(book, board) != NULL;
+	return book_probe(book, board) != NULL || (list && board_list_contains(list, board));
+}
+
+/**
+ * @brief Compare two boards by their number of empty squares.
+ */
+static int board_empties_cmp(const void *a, const void *b)
+{
+	return board_count_empties((const Board*) a) - board_count_empties((const Board*) b);
+}
+
+/**
+ * @brief Add a list of boards to the book, evaluating several positions simultaneously.
+ *
+ * Same as calling book_add_board() on each board. The boards are added by
+ * increasing number of empties, so that a new position links to the new
+ * positions following it.
+ *
+ * @param book Opening book.
+ * @param workers Searches evaluating the positions.
+ * @param list Boards to add.
+ */
+static void book_add_boards(Book *book, BookWorkers *workers, BoardList *list)
+{
+	Position *position = (Position*) malloc(list->n * sizeof (Position) + 1);
+	Position **evaluated = (Position**) malloc(list->n * sizeof (Position*) + 1);
+	Position *probe;
+	int i, j, k, n, n_new;
+
+	if (position == NULL || evaluated == NULL) fatal_error("cannot allocate the positions to add to the book\n");
+
+	qsort(list->board, list->n, sizeof (Board), board_empties_cmp);
+
+	for (i = 0; i < list->n; i = j) {
+		const int n_empties = board_count_empties(list->board + i);
+		for (j = i + 1; j < list->n && board_count_empties(list->board + j) == n_empties; ++j) ;
+		if (n_empties < book->options.n_empties - 1) continue;
+
+		for (n = n_new = 0, k = i; k < j; ++k) {
+			probe = book_probe(book, list->board + k);
+			if (probe) {
+				position_link(probe, book);
+				if (probe->leaf.move == NOMOVE) evaluated[n++] = probe;
+			} else {
+				position_init(position + n_new);
+				position[n_new].board = list->board[k];
+				position[n_new].level = book->options.level;
+				position_link(position + n_new, book);
+				evaluated[n++] = position + n_new++;
+			}
+		}
+		book_workers_evaluate(book, workers, evaluated, n, false);
+
+		for (k = 0; k < n_new; ++k) {
+			position_unique(position + k);
+			book_add(book, position + k);
+		}
+	}
+	list->n = 0;
+
+	free(evaluated);
+	free(position);
 }
 
 /**
@@ -1190,12 +1736,12 @@ static void position_fix(Position *position, Book *book)
 
 	if ((position->board.player & position->board.opponent) ||
 	    ((position->board.player | position->board.opponent) & 0x0000001818000000ULL) != 0x0000001818000000ULL) {
-		position_free(position);
+		position_free(position, &book->arena);
 		position_init(position);
 		return;
 	}
 	board_unique(&position->board, &board);
-	position_free(position);
+	position_free(position, &book->arena);
 	position_init(position);
 	position->board = board;
 	position->level = book->options.level;
@@ -1204,112 +1750,197 @@ static void position_fix(Position *position, Book *book)
 }
 
 /**
- * @brief An array with positions.
+ * @brief A slot of the position index.
+ *
+ * The index is an open-addressing hash table, with linear probing, over the
+ * contiguous array of the book positions.
  */
-typedef struct PositionArray {
-	Position *positions;
-	int n;
-	int size;
-} PositionArray;
+typedef struct PositionSlot {
+	uint32_t hash;     /**< hash code (lower bits) */
+	int32_t i;         /**< position index (or -1 if the slot is empty) */
+} PositionSlot;
 
+/**
+ * @brief A position of a mapped book file.
+ *
+ * Same contents as a Position, with its links stored in the link array of
+ * the file. All the fields have a fixed width and are naturally aligned, so
+ * the record has no padding: in the file, it is stored in little-endian order.
+ */
+typedef struct BookRecord {
+	Board board;               /**< (unique) board */
+	uint32_t n_wins;           /**< game win count */
+	uint32_t n_draws;          /**< game draw count */
+	uint32_t n_losses;         /**< game loss count */
+	uint32_t n_lines;          /**< unterminated line count */
+	struct {
+		int16_t value, lower, upper;
+	} score;                   /**< Position value & bounds */
+	uint8_t n_link;            /**< linking moves number */
+	uint8_t level;             /**< search level */
+	Link leaf;                 /**< best remaining move */
+	uint16_t reserved;         /**< unused (0) */
+	uint32_t link;             /**< first linking move in the link array */
+} BookRecord;
+
+_Static_assert(sizeof (Link) == 2, "a book link must be 2 bytes long");
+_Static_assert(sizeof (PositionSlot) == 8, "a position slot must be 8 bytes long");
+_Static_assert(sizeof (BookRecord) == 48, "a book record must be 48 bytes long");
 
 /**
- * @brief Initialize the array.
+ * @brief Header of a mapped book file.
+ *
+ * The header is stored field by field, in little-endian order:
+ *   - 0: EDAX tag (32 bits) & BMAP tag (32 bits)
+ *   - 8: version & release (8 bits each)
+ *   - 10: date: year (16 bits), month, day, hour, minute & second (8 bits each)
+ *   - 20: options: level, n_empties, midgame_error, endcut_error & verbosity (32 bits each)
+ *   - 40: number of positions & index size (32 bits each)
+ *   - 48: number of links (64 bits)
  *
- * @param a Positions' array.
+ * The header is followed by the positions, the position index and the links.
  */
-static void position_array_init(PositionArray *a)
+#define BMAP_HEADER_SIZE 64
+
+/**
+ * @brief A book used directly from its mapped file.
+ */
+typedef struct BookMap {
+	void *address;             /**< mapped file */
+	size_t size;               /**< mapped size */
+	const BookRecord *record;  /**< positions */
+	const Link *link;          /**< links */
+} BookMap;
+
+/** tag of the mapped book file format */
+#define BMAP 0x424d4150
+
+/**
+ * @brief Convert a book record between the host and the file (little-endian) order.
+ *
+ * @param record Book record.
+ */
+static void book_record_le(BookRecord *record)
 {
-	a->size = a->n = 0;
-	a->positions = NULL;
+#ifdef __BIG_ENDIAN__
+	record->board.player = bswap(record->board.player);
+	record->board.opponent = bswap(record->board.opponent);
+	record->n_wins = bswap(record->n_wins);
+	record->n_draws = bswap(record->n_draws);
+	record->n_losses = bswap(record->n_losses);
+	record->n_lines = bswap(record->n_lines);
+	record->score.value = bswap(record->score.value);
+	record->score.lower = bswap(record->score.lower);
+	record->score.upper = bswap(record->score.upper);
+	record->link = bswap(record->link);
+#else
+	(void) record;
+#endif
 }
 
 /**
- * @brief Add a position to the array.
+ * @brief Convert a position slot between the host and the file (little-endian) order.
  *
- * @param a Positions' array.
- * @param p Position to add.
- * @return true in case of success.
+ * @param slot Position slot.
  */
-static bool position_array_add(PositionArray *a, const Position *p)
+static void position_slot_le(PositionSlot *slot)
 {
-	int i;
+#ifdef __BIG_ENDIAN__
+	slot->hash = bswap(slot->hash);
+	slot->i = bswap(slot->i);
+#else
+	(void) slot;
+#endif
+}
 
-	board_check(&p->board);
-	assert(position_is_ok(p));
+/** tag of the book journal file format */
+#define JRNL 0x4a524e4c
 
-	for (i = 0; i < a->n; ++i) if (board_equal(&a->positions[i].board, &p->board)) return false;
-	if (a->n == a->size) {
-		Position *n;
-		a->size += a->size / 2 + 1;
-		n = (Position*) realloc(a->positions, a->size * sizeof (Position));
-		if (n == NULL) {
-			error("cannot add a position to the book\n");
-			a->size = a->n;
-			return false;
-		}
-		a->positions = n;
-	}
-	a->positions[a->n] = *p;
-	a->positions[a->n].done = true;
-	a->positions[a->n].todo = false;
-	++a->n;
-	return true;
-}
+#define foreach_position(p, b) \
+	for (p = b->positions; p < b->positions + b->n_nodes; ++p)
+
+#define foreach_position_view(p, i, b, buffer) \
+	for (i = 0; i < b->n_nodes && (p = book_get_position(b, i, &buffer)) != NULL; ++i)
 
 /**
- * @brief Remove a position from an array.
+ * @brief Get a position from a book record.
  *
- * @param a Positions' array.
- * @param p Position to add.
- * @return true in case of success.
+ * The links are not copied, and stay in the mapped file.
+ *
+ * @param position Position.
+ * @param record Book record.
+ * @param link Link array.
  */
-static bool position_array_remove(PositionArray *a, const Position *p)
+static void position_from_record(Position *position, const BookRecord *record, const Link *link)
 {
-	int i, j;
-
-	for (i = 0; i < a->n; ++i) {
-		if (board_equal(&a->positions[i].board, &p->board)) {
-			position_free(a->positions + i);
-			for (j = i + 1; j < a->n; ++j) {
-				a->positions[j - 1] = a->positions[j];
-			}
-			--a->n;
-			return true;
-		}
-	}
-	return false;
+	position->board = record->board;
+	position->leaf = record->leaf;
+	position->link = (Link*) (link + record->link);
+	position->n_wins = record->n_wins;
+	position->n_draws = record->n_draws;
+	position->n_losses = record->n_losses;
+	position->n_lines = record->n_lines;
+	position->score.value = record->score.value;
+	position->score.lower = record->score.lower;
+	position->score.upper = record->score.upper;
+	position->n_link = record->n_link;
+	position->level = record->level;
+	position->done = position->todo = false;
+	position->checksum = 0;
 }
 
 /**
- * @brief Free resources used by a position array.
+ * @brief Store a position into a book record.
  *
- * @param a Positions' array.
+ * @param position Position.
+ * @param record Book record.
+ * @param link Index of the first linking move in the link array.
  */
-static void position_array_free(PositionArray *a)
+static void position_to_record(const Position *position, BookRecord *record, const unsigned int link)
 {
-	int i;
-	for (i = 0; i < a->n; ++i) position_free(a->positions + i);
-	free(a->positions);
+	record->board = position->board;
+	record->n_wins = position->n_wins;
+	record->n_draws = position->n_draws;
+	record->n_losses = position->n_losses;
+	record->n_lines = position->n_lines;
+	record->score.value = position->score.value;
+	record->score.lower = position->score.lower;
+	record->score.upper = position->score.upper;
+	record->n_link = position->n_link;
+	record->level = position->level;
+	record->leaf = position->leaf;
+	record->reserved = 0;
+	record->link = link;
 }
 
 /**
- * @brief Find a position in the array.
+ * @brief Get the board of a book position.
  *
- * @param a Positions' array.
- * @param board Board to find in the array.
- * @return a position containg the board (or a symetry) or NULL is no position is found.
+ * @param book Opening book.
+ * @param i Position index.
+ * @return the board.
  */
-static Position* position_array_probe(PositionArray *a, const Board *board)
+static inline const Board* book_get_board(const Book *book, const int i)
 {
-	int i;
-	for (i = 0; i < a->n; ++i) if (board_equal(&a->positions[i].board, board)) return a->positions + i;
-	return NULL;
+	return book->map ? &book->map->record[i].board : &book->positions[i].board;
 }
 
-#define foreach_position(p, a, b) \
-	for (a = b->array; a < b->array + b->n; ++a) \
-	for (p = a->positions; p < a->positions + a->n; ++p)
+/**
+ * @brief Get a book position, for reading only.
+ *
+ * @param book Opening book.
+ * @param i Position index.
+ * @param buffer Storage for a position of a mapped book.
+ * @return the position.
+ */
+static const Position* book_get_position(const Book *book, const int i, Position *buffer)
+{
+	if (book->map) {
+		position_from_record(buffer, book->map->record + i, book->map->link);
+		return buffer;
+	}
+	return book->positions + i;
+}
 
 /**
  * @brief Set book date.
@@ -1355,6 +1986,85 @@ static double book_get_age(Book *book)
 
 
 
+/**
+ * @brief (Re)build the position index.
+ *
+ * @param book Opening book.
+ * @param n Index size (a power of 2).
+ * @return true in case of success.
+ */
+static bool book_index(Book *book, const int n)
+{
+	PositionSlot *index = (PositionSlot*) malloc(n * sizeof (PositionSlot));
+	const unsigned int mask = n - 1;
+	unsigned int j;
+	int i;
+
+	if (index == NULL) return false;
+	for (j = 0; j < (unsigned int) n; ++j) index[j].i = -1;
+	for (i = 0; i < book->n_nodes; ++i) {
+		const uint32_t hash = (uint32_t) board_get_hash_code(&book->positions[i].board);
+		for (j = hash & mask; index[j].i >= 0; j = (j + 1) & mask) ;
+		index[j].hash = hash;
+		index[j].i = i;
+	}
+	free(book->index);
+	book->index = index;
+	book->n = n;
+	return true;
+}
+
+/**
+ * @brief Count the probes needed to find the position of an index slot.
+ *
+ * @param book Opening book.
+ * @param j Index slot.
+ * @return the number of probes.
+ */
+static int book_probe_length(const Book *book, const unsigned int j)
+{
+	const unsigned int mask = book->n - 1;
+	return (int) ((j - (book->index[j].hash & mask)) & mask) + 1;
+}
+
+/**
+ * @brief Find the index slot of a position.
+ *
+ * @param book Opening book.
+ * @param board Unique board to find.
+ * @param hash Board hash code.
+ * @return the slot containing the board, or the empty slot where to add it.
+ */
+static unsigned int book_find(const Book *book, const Board *board, const uint32_t hash)
+{
+	const PositionSlot *index = book->index;
+	const unsigned int mask = book->n - 1;
+	unsigned int j;
+
+	for (j = hash & mask; index[j].i >= 0; j = (j + 1) & mask) {
+		if (index[j].hash == hash && board_equal(book_get_board(book, index[j].i), board)) break;
+	}
+	return j;
+}
+
+/**
+ * @brief Find a position in the book, for reading only.
+ *
+ * @param book Opening book.
+ * @param board Board to find in the array.
+ * @param buffer Storage for a position of a mapped book.
+ * @return a position containg the board (or a symetry) or NULL is no position is found.
+ */
+static const Position* book_view(const Book *book, const Board *board, Position *buffer)
+{
+	Board unique;
+	unsigned int j;
+
+	board_unique(board, &unique);
+	j = book_find(book, &unique, (uint32_t) board_get_hash_code(&unique));
+	return book->index[j].i >= 0 ? book_get_position(book, book->index[j].i, buffer) : NULL;
+}
+
 /**
  * @brief Find a position in the book.
  *
@@ -1365,39 +2075,100 @@ static double book_get_age(Book *book)
 static Position* book_probe(const Book *book, const Board *board)
 {
 	Board unique;
+	unsigned int j;
+
+	assert(book->map == NULL);
 	board_unique(board, &unique);
-	return position_array_probe(book->array + (board_get_hash_code(&unique) & (book->n - 1)), &unique);
+	j = book_find(book, &unique, (uint32_t) board_get_hash_code(&unique));
+	return book->index[j].i >= 0 ? book->positions + book->index[j].i : NULL;
 }
 
 /**
  * @brief Add a position to the book.
  *
+ * Attention: the book positions may move in memory.
+ *
  * @param book Opening book.
  * @param p Position to add.
  */
 static void book_add(Book *book, const Position *p)
 {
-	const uint64_t i = board_get_hash_code(&p->board) & (book->n - 1);
+	const uint32_t hash = (uint32_t) board_get_hash_code(&p->board);
+	unsigned int j;
+	Position *q;
+
+	board_check(&p->board);
+	assert(position_is_ok(p));
 
-	if (position_array_add(book->array + i, p)) {
-		++book->n_nodes;
-		++book->stats.n_nodes;
+	j = book_find(book, &p->board, hash);
+	if (book->index[j].i >= 0) return;
+
+	if (book->n_nodes == book->size) {
+		const int size = book->size + book->size / 2 + 1024;
+		Position *positions = (Position*) realloc(book->positions, size * sizeof (Position));
+		if (positions == NULL) {
+			error("cannot add a position to the book\n");
+			return;
+		}
+		book->positions = positions;
+		book->size = size;
+	}
+	if (4 * (book->n_nodes + 1) > 3 * book->n) {
+		if (!book_index(book, 2 * book->n)) {
+			error("cannot add a position to the book\n");
+			return;
+		}
+		j = book_find(book, &p->board, hash);
 	}
+
+	q = book->positions + book->n_nodes;
+	*q = *p;
+	q->done = true;
+	q->todo = false;
+	book->index[j].hash = hash;
+	book->index[j].i = book->n_nodes;
+	++book->n_nodes;
+	++book->stats.n_nodes;
 }
 
 /**
  * @brief Remove a position from the book.
  *
+ * The last position of the book takes the place of the removed one.
+ *
  * @param book Opening book.
- * @param p Position to add.
+ * @param p Position to remove.
  */
 static void book_remove(Book *book, const Position *p)
 {
-	const uint64_t i = board_get_hash_code(&p->board) & (book->n - 1);
-
-	if (position_array_remove(book->array + i, p)) {
-		--book->n_nodes;
-		--book->stats.n_nodes;
+	PositionSlot *index = book->index;
+	const unsigned int mask = book->n - 1;
+	const Board board = p->board;
+	unsigned int j, k, home;
+	int i, last;
+
+	j = book_find(book, &board, (uint32_t) board_get_hash_code(&board));
+	if ((i = index[j].i) < 0) return;
+	book->need_compaction = true; // the journal cannot record a removal
+
+	// remove the slot, shifting back the following slots of the cluster
+	for (k = (j + 1) & mask; index[k].i >= 0; k = (k + 1) & mask) {
+		home = index[k].hash & mask;
+		if (((k - home) & mask) >= ((k - j) & mask)) {
+			index[j] = index[k];
+			j = k;
+		}
+	}
+	index[j].i = -1;
+
+	// move the last position into the hole
+	position_free(book->positions + i, &book->arena);
+	last = --book->n_nodes;
+	--book->stats.n_nodes;
+	if (i != last) {
+		j = book_find(book, &book->positions[last].board, (uint32_t) board_get_hash_code(&book->positions[last].board));
+		index[j].i = i;
+		book->positions[i] = book->positions[last];
 	}
 }
 
@@ -1408,10 +2179,243 @@ static void book_remove(Book *book, const Position *p)
  */
 static void book_clean(Book *book)
 {
-	PositionArray *a;
 	Position *p;
 	book->stats.n_nodes = book->stats.n_links = book->stats.n_todo = 0;
-	foreach_position(p, a, book) p->done = p->todo = false;
+	foreach_position(p, book) p->done = p->todo = false;
+}
+
+/** number of positions processed at once by a thread of a book pass */
+#define BOOK_PASS_CHUNK 1024
+
+/** number of position levels of a book pass */
+#define BOOK_PASS_N_LEVELS (2 * 61)
+
+/**
+ * @brief A pass over book positions, processed by several threads.
+ *
+ * A pass function may modify the processed position, and read the positions
+ * processed by a previous pass.
+ */
+typedef struct BookPass {
+	Book *book;                                /**< opening book */
+	void (*run)(struct BookPass*, const int);  /**< function processing a position */
+	const int *order;                          /**< positions to process (or NULL for all positions) */
+	int n;                                     /**< number of positions to process */
+	_Atomic int i;                             /**< next position to process */
+	_Atomic int count;                         /**< counter of the pass */
+	_Atomic unsigned char *mark;               /**< position marks */
+	short *value;                              /**< position values before the pass */
+	unsigned char *n_link;                     /**< position link numbers before the pass */
+} BookPass;
+
+/**
+ * @brief Process the positions of a pass, chunk by chunk.
+ *
+ * @param v Book pass.
+ * @return thrd_success.
+ */
+static int book_pass_thread(void *v)
+{
+	BookPass *pass = (BookPass*) v;
+	int i, j, n;
+
+	while ((i = atomic_fetch_add(&pass->i, BOOK_PASS_CHUNK)) < pass->n) {
+		n = MIN(i + BOOK_PASS_CHUNK, pass->n);
+		for (j = i; j < n; ++j) pass->run(pass, pass->order ? pass->order[j] : j);
+	}
+
+	return thrd_success;
+}
+
+/**
+ * @brief Run a pass over book positions, with up to n-tasks threads.
+ *
+ * @param pass Book pass.
+ * @param run Function processing a position.
+ * @param order Positions to process (or NULL for all positions).
+ * @param n Number of positions to process.
+ */
+static void book_pass_run(BookPass *pass, void (*run)(BookPass*, const int), const int *order, const int n)
+{
+	thrd_t thread[MAX_THREADS];
+	const int n_threads = MIN(options.n_task, (n + BOOK_PASS_CHUNK - 1) / BOOK_PASS_CHUNK);
+	int t;
+
+	pass->run = run;
+	pass->order = order;
+	pass->n = n;
+	atomic_init(&pass->i, 0);
+
+	for (t = 1; t < n_threads; ++t) thrd_create(thread + t, book_pass_thread, pass);
+	book_pass_thread(pass);
+	for (t = 1; t < n_threads; ++t) thrd_join(thread[t], NULL);
+}
+
+/**
+ * @brief Sort the positions by level, for passes going through the book level by level.
+ *
+ * Level 2 * e gathers the positions with e empties and some moves; level 2 * e + 1 the
+ * positions with e empties and no move, whose (passing) link leads to level 2 * e.
+ * So the child positions of a level are all in a lower level.
+ *
+ * @param book Opening book.
+ * @param first Index of the first position of each level (output).
+ * @return The position indices, sorted by level.
+ */
+static int* book_pass_levels(const Book *book, int first[BOOK_PASS_N_LEVELS + 1])
+{
+	int *order = (int*) malloc(book->n_nodes * sizeof (int) + 1);
+	int *level = (int*) malloc(book->n_nodes * sizeof (int) + 1);
+	int i, k;
+
+	if (order == NULL || level == NULL) fatal_error("cannot allocate the book levels\n");
+
+	for (k = 0; k <= BOOK_PASS_N_LEVELS; ++k) first[k] = 0;
+	for (i = 0; i < book->n_nodes; ++i) {
+		const Board *board = &book->positions[i].board;
+		level[i] = 2 * board_count_empties(board) + (board_get_moves(board) == 0);
+		++first[level[i] + 1];
+	}
+	for (k = 0; k < BOOK_PASS_N_LEVELS; ++k) first[k + 1] += first[k];
+	for (i = 0; i < book->n_nodes; ++i) order[first[level[i]]++] = i;
+	for (k = BOOK_PASS_N_LEVELS; k > 0; --k) first[k] = first[k - 1];
+	first[0] = 0;
+
+	free(level);
+	return order;
+}
+
+/**
+ * @brief Find the child positions of a position in the book.
+ *
+ * @param position Position.
+ * @param book Opening book.
+ * @param child Child positions (output).
+ * @param move Moves leading to the child positions (output).
+ * @return The number of child positions.
+ */
+static int position_get_children(const Position *position, const Book *book, Position **child, int *move)
+{
+	int x, n = 0;
+	uint64_t moves = board_get_moves(&position->board);
+	Board next;
+
+	if (moves) {
+		foreach_bit(x, moves) {
+			board_next(&position->board, x, &next);
+			if ((child[n] = book_probe(book, &next)) != NULL) move[n++] = x;
+		}
+	} else if (can_move(position->board.opponent, position->board.player)) {// pass ?
+		next.player = position->board.opponent;
+		next.opponent = position->board.player;
+		if ((child[n] = book_probe(book, &next)) != NULL) move[n++] = PASS;
+	}
+
+	return n;
+}
+
+/**
+ * @brief Mark the child positions of a marked position.
+ *
+ * @param pass Book pass.
+ * @param i Position index.
+ */
+static void position_mark_children(BookPass *pass, const int i)
+{
+	const Book *book = pass->book;
+	const Position *position = book->positions + i;
+	const Link *l;
+	Board target;
+
+	if (atomic_load_explicit(pass->mark + i, memory_order_relaxed)) {
+		foreach_link(l, position) {
+			board_next(&position->board, l->move, &target);
+			atomic_store_explicit(pass->mark + (book_probe(book, &target) - book->positions), 1, memory_order_relaxed);
+		}
+	}
+}
+
+/**
+ * @brief Negamax a marked position.
+ *
+ * @param pass Book pass.
+ * @param i Position index.
+ */
+static void position_negamax_marked(BookPass *pass, const int i)
+{
+	Position *position = pass->book->positions + i;
+
+	if (atomic_load_explicit(pass->mark + i, memory_order_relaxed)) {
+		position->done = true;
+		if (position_negamax_update(position, pass->book)) atomic_fetch_add(&pass->count, 1);
+	}
+}
+
+/**
+ * @brief Add the links of a position, with undefined scores.
+ *
+ * @param pass Book pass.
+ * @param i Position index.
+ */
+static void position_link_moves(BookPass *pass, const int i)
+{
+	Book *book = pass->book;
+	Position *position = book->positions + i;
+	Position *child[MAX_MOVE];
+	int move[MAX_MOVE];
+	Link link;
+	int j, n, n_links = 0;
+
+	pass->value[i] = position->score.value;
+	pass->n_link[i] = position->n_link;
+
+	n = position_get_children(position, book, child, move);
+	for (j = 0; j < n; ++j) {
+		link.score = -SCORE_INF; // below any score: does not change the position score
+		link.move = move[j];
+		n_links += position_add_link(position, &link, &book->arena);
+	}
+	if (n_links) atomic_fetch_add(&pass->count, n_links);
+}
+
+/**
+ * @brief Score the links of a position.
+ *
+ * As a serial pass would, use the scores of the child positions linked before the
+ * position and the former scores of the child positions linked after it.
+ *
+ * @param pass Book pass.
+ * @param i Position index.
+ */
+static void position_link_scores(BookPass *pass, const int i)
+{
+	const Book *book = pass->book;
+	Position *position = book->positions + i;
+	Position *child[MAX_MOVE];
+	int move[MAX_MOVE];
+	Link *l;
+	int j, k, n;
+
+	n = position_get_children(position, book, child, move);
+	for (j = 0; j < n; ++j) {
+		k = child[j] - book->positions;
+		foreach_link(l, position) if (l->move == move[j]) {
+			l->score = -(k < i ? child[j]->score.value : pass->value[k]);
+			if (l - position->link >= pass->n_link[i] && l->score > position->score.value) position->score.value = l->score;
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Mark the positions needing a fix.
+ *
+ * @param pass Book pass.
+ * @param i Position index.
+ */
+static void position_check_marked(BookPass *pass, const int i)
+{
+	if (!position_check(pass->book->positions + i, false)) atomic_store_explicit(pass->mark + i, 1, memory_order_relaxed);
 }
 
 /**
@@ -1442,8 +2446,6 @@ static Position *book_root(Book *book)
  */
 void book_init(Book *book)
 {
-	int i;
-
 	book_set_date(book);
 
 	book->options.level = 21;
@@ -1451,12 +2453,16 @@ void book_init(Book *book)
 	book->options.midgame_error = 2;
 	book->options.endcut_error = 1;
 
-	book->n = 65536;
-	book->array = (PositionArray*) malloc(book->n * sizeof *book->array);
-	if (book->array == NULL) fatal_error("cannot allocate space to store the positions");
-	for (i = 0; i < book->n; ++i) position_array_init(book->array + i);
+	book->positions = NULL;
+	book->index = NULL;
+	book->map = NULL;
+	book->size = book->n_nodes = 0;
+	book->need_compaction = false;
+	link_arena_init(&book->arena);
+	book->snapshot = NULL;
+	spinlock_init(&book->snapshot_lock);
+	if (!book_index(book, 65536)) fatal_error("cannot allocate space to store the positions");
 
-	book->n_nodes = 0;
 	random_seed(&book->random, real_clock());
 	book->need_saving = false;
 }
@@ -1468,11 +2474,151 @@ void book_init(Book *book)
  */
 void book_free(Book *book)
 {
+	if (book->map) {
+		file_unmap(book->map->address, book->map->size);
+		free(book->map);
+		book->map = NULL;
+	} else {
+		free(book->positions);
+		free(book->index);
+	}
+	link_arena_free(&book->arena);
+	book_release(book);
+}
+
+/**
+ * @brief Copy a mapped book into memory, to modify it.
+ *
+ * @param book Opening book.
+ */
+static void book_unmap(Book *book)
+{
+	const BookMap *map = book->map;
+	const PositionSlot *index = book->index;
+	Position *p;
 	int i;
-	for (i = 0; i < book->n; ++i) {
-		position_array_free(book->array + i);
+
+	if (map == NULL) return;
+
+	book->positions = (Position*) malloc(book->n_nodes * sizeof (Position) + 1);
+	book->index = (PositionSlot*) malloc(book->n * sizeof (PositionSlot));
+	if (book->positions == NULL || book->index == NULL) fatal_error("cannot allocate space to store the positions");
+	memcpy(book->index, index, book->n * sizeof (PositionSlot));
+	for (i = 0; i < book->n; ++i) position_slot_le(book->index + i);
+
+	for (i = 0; i < book->n_nodes; ++i) {
+		BookRecord record = map->record[i];
+		book_record_le(&record);
+		p = book->positions + i;
+		position_from_record(p, &record, map->link);
+		if (p->n_link) {
+			p->link = link_alloc(&book->arena, p->n_link);
+			if (p->link == NULL) fatal_error("cannot allocate opening book position's moves\n");
+			memcpy(p->link, map->link + record.link, p->n_link * sizeof (Link));
+		} else {
+			p->link = NULL;
+		}
 	}
-	free(book->array);
+	book->size = book->n_nodes;
+
+	file_unmap(map->address, map->size);
+	free(book->map);
+	book->map = NULL;
+}
+
+/**
+ * @brief Use an opening book directly from its mapped file.
+ *
+ * On a little-endian host, the book is used in place, without reading it. It
+ * is copied into memory only when it is modified. On a big-endian host, it is
+ * copied into memory at once.
+ * Every position index & link range is checked against the file size, so a
+ * corrupted file cannot make the book read outside of it.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ * @return true in case of success.
+ */
+static bool book_load_map(Book *book, const char *file)
+{
+	BookMap *map = (BookMap*) malloc(sizeof (BookMap));
+	const unsigned char *header;
+	const PositionSlot *index;
+	PositionSlot slot;
+	BookRecord record;
+	int64_t n_nodes, n;
+	uint64_t n_links, size;
+	int i;
+
+	if (map == NULL || (map->address = file_map(file, &map->size)) == NULL) {
+		error("cannot map %s", file);
+		free(map);
+		return false;
+	}
+
+	header = (const unsigned char*) map->address;
+	if (map->size < BMAP_HEADER_SIZE || get_le(header, 4) != EDAX || get_le(header + 4, 4) != BMAP || header[8] != VERSION) {
+		error("%s is not a compatible edax mapped opening book", file);
+		goto fail;
+	}
+
+	n_nodes = (int32_t) get_le(header + 40, 4);
+	n = (int32_t) get_le(header + 44, 4);
+	n_links = get_le(header + 48, 8);
+	if (n_nodes < 0 || n <= n_nodes || (n & (n - 1)) || n_links > UINT_MAX) {
+		error("%s is a corrupted edax mapped opening book", file);
+		goto fail;
+	}
+	size = BMAP_HEADER_SIZE + n_nodes * sizeof (BookRecord) + n * sizeof (PositionSlot) + n_links * sizeof (Link);
+	if (size > map->size) {
+		error("%s is a truncated edax mapped opening book", file);
+		goto fail;
+	}
+
+	map->record = (const BookRecord*) (header + BMAP_HEADER_SIZE);
+	index = (const PositionSlot*) (map->record + n_nodes);
+	map->link = (const Link*) (index + n);
+	for (i = 0; i < n_nodes; ++i) {
+		record = map->record[i];
+		book_record_le(&record);
+		if (record.link + (uint64_t) record.n_link > n_links) break;
+	}
+	if (i == n_nodes) for (i = 0; i < n; ++i) {
+		slot = index[i];
+		position_slot_le(&slot);
+		if (slot.i < -1 || slot.i >= n_nodes) break;
+	}
+	if (i < n) {
+		error("%s is a corrupted edax mapped opening book", file);
+		goto fail;
+	}
+
+	book->date.year = (short) get_le(header + 10, 2);
+	book->date.month = (char) header[12];
+	book->date.day = (char) header[13];
+	book->date.hour = (char) header[14];
+	book->date.minute = (char) header[15];
+	book->date.second = (char) header[16];
+	book->options.level = (int32_t) get_le(header + 20, 4);
+	book->options.n_empties = (int32_t) get_le(header + 24, 4);
+	book->options.midgame_error = (int32_t) get_le(header + 28, 4);
+	book->options.endcut_error = (int32_t) get_le(header + 32, 4);
+	book->options.verbosity = (int32_t) get_le(header + 36, 4);
+	book->n_nodes = (int) n_nodes;
+	book->n = (int) n;
+	book->size = 0;
+	book->positions = NULL;
+	book->index = (PositionSlot*) index;
+	book->map = map;
+#ifdef __BIG_ENDIAN__
+	book_unmap(book);
+#endif
+	return true;
+
+fail:
+	file_unmap(map->address, map->size);
+	free(map);
+	return false;
 }
 
 /**
@@ -1512,12 +2658,28 @@ void book_load(Book *book, const char *file)
 		Position p;
 		unsigned int header_edax, header_book;
 		unsigned char header_version, header_release;
-		int i;
+		int n;
 		int r;
 
 		info("Loading book from %s...", file);
 		r = fread(&header_edax, sizeof (unsigned int), 1, f);
 		r += fread(&header_book, sizeof (unsigned int), 1, f);
+		book->map = NULL;
+		book->need_compaction = false;
+		link_arena_init(&book->arena);
+		book->snapshot = NULL;
+		spinlock_init(&book->snapshot_lock);
+		if (r == 2 && header_edax == EDAX && header_book == BMAP) {
+			fclose(f);
+			if (!book_load_map(book, file)) {
+				book_new(book, options.level, 61 - get_book_depth(options.level));
+				return;
+			}
+			random_seed(&book->random, real_clock());
+			book->need_saving = false;
+			info("done\n");
+			return;
+		}
 		if (r != 2 || header_edax != EDAX || header_book != BOOK) {
 			error("%s is not an edax opening book", file);
 			book_new(book, options.level, 61 - get_book_depth(options.level));
@@ -1541,19 +2703,19 @@ void book_load(Book *book, const char *file)
 			return;
 		}
 
-		book->n = 65536;
-		while ((book->n << 4) < book->n_nodes) book->n <<= 1;
-
-		book->array = (PositionArray*) malloc(book->n * sizeof (PositionArray));
-		if (book->array == NULL) {
+		book->size = MAX(book->n_nodes, 0);
+		for (n = 65536; 3 * n < 4 * book->size; n <<= 1) ;
+		book->positions = (Position*) malloc(book->size * sizeof (Position) + 1);
+		book->index = NULL;
+		book->n_nodes = 0;
+		if (book->positions == NULL || !book_index(book, n)) {
 			error("cannot allocate space to store the positions");
 			book_new(book, options.level, 61 - get_book_depth(options.level));
 			return;
 		}
-		for (i = 0; i < book->n; ++i) position_array_init(book->array + i);
 
-		book->n_nodes = 0;
-		while (position_read(&p, f)) {
+		while (position_read(&p, f, &book->arena)) {
+			p.checksum = position_checksum(&p);
 			book_add(book, &p);
 		}
 
@@ -1566,6 +2728,8 @@ void book_load(Book *book, const char *file)
 
 		info("done\n");
 		fclose(f);
+
+		book_replay(book, file);
 	} else {
 		book_new(book, options.level, 60 - get_book_depth(options.level));
 	}
@@ -1585,7 +2749,6 @@ void book_import(Book *book, const char *file)
 {
 	FILE *f = fopen(file, "r");
 	if (f) {
-		PositionArray *a;
 		Position *p, position;
 		int n_empties;
 
@@ -1598,7 +2761,7 @@ void book_import(Book *book, const char *file)
 
 		book->options.n_empties = 60;
 		book->options.level = 0;
-		foreach_position(p, a, book) {
+		foreach_position(p, book) {
 			n_empties = board_count_empties(&p->board);
 			if (p->level > book->options.level) book->options.level = p->level;
 			if (n_empties < book->options.n_empties) book->options.n_empties = n_empties;
@@ -1607,92 +2770,544 @@ void book_import(Book *book, const char *file)
 		random_seed(&book->random, real_clock());
 		book->need_saving = true;
 
-		bprint("...done\n");
-		fclose(f);
-	} else {
-		error("cannot open \"%s\" to import the opening book\n", file);
-		book_new(book, options.level, 61 - get_book_depth(options.level));
+		bprint("...done\n");
+		fclose(f);
+	} else {
+		error("cannot open \"%s\" to import the opening book\n", file);
+		book_new(book, options.level, 61 - get_book_depth(options.level));
+	}
+}
+
+/**
+ * @brief Export an opening book.
+ *
+ * Save the book in a portable text format.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ */
+void book_export(Book *book, const char *file)
+{
+	FILE *f;
+	const Position *p;
+	Position buffer;
+	int i;
+
+	f = fopen(file, "w");
+	if (f == NULL) {
+		error("cannot open file %s", file);
+		return;
+	}
+
+	info("Exporting book to %s...", file);
+	foreach_position_view(p, i, book, buffer) {
+		if (!position_export(p, f)) {
+			error("cannot export book to %s", file);
+			goto book_export_end;
+		}
+	}
+	info("done\n");
+
+book_export_end:
+	fclose(f);
+}
+
+/**
+ * @brief Check the header of a book or journal file.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ * @param tag Expected file type (BOOK or JRNL).
+ * @param size File size (output).
+ * @return true if the file has the expected type and the book's date.
+ */
+static bool book_check_header(const Book *book, const char *file, const unsigned int tag, long *size)
+{
+	unsigned int header_edax, header_book;
+	unsigned char header_version, header_release;
+	FILE *f = fopen(file, "rb");
+	bool ok = false;
+
+	if (f) {
+		char date[sizeof book->date];
+		int r;
+
+		r = fread(&header_edax, sizeof (unsigned int), 1, f);
+		r += fread(&header_book, sizeof (unsigned int), 1, f);
+		r += fread(&header_version, 1, 1, f);
+		r += fread(&header_release, 1, 1, f);
+		r += fread(date, sizeof date, 1, f);
+		ok = (r == 5 && header_edax == EDAX && header_book == tag && header_version == VERSION
+			&& memcmp(date, &book->date, sizeof date) == 0);
+		fseek(f, 0, SEEK_END);
+		*size = ftell(f);
+		fclose(f);
+	}
+
+	return ok;
+}
+
+/**
+ * @brief Save an opening book.
+ *
+ * Save the book in a fast binary format. The book is written into a temporary
+ * file renamed at the end, so a crash never leaves a partially written book.
+ * The journal of the previous save is removed.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ */
+void book_save(Book *book, const char *file)
+{
+	unsigned int header_edax = EDAX, header_book = BOOK;
+	unsigned char header_version = VERSION, header_release = RELEASE;
+	char tmp_file[FILENAME_MAX + 1], journal[FILENAME_MAX + 1];
+	FILE *f;
+	int r;
+	bool ok;
+	Position *p;
+
+	book_unmap(book); // the mapped file may be the one to overwrite
+	file_add_ext(file, ".tmp", tmp_file);
+	file_add_ext(file, ".jnl", journal);
+	f = fopen(tmp_file, "wb");
+	if (f == NULL) {
+		error("Cannot open file: %s", tmp_file);
+		return;
+	}
+
+	info("Saving book to %s...", file);
+	book_set_date(book);
+
+	r = fwrite(&header_edax, sizeof (unsigned int), 1, f);
+	r += fwrite(&header_book, sizeof (unsigned int), 1, f);
+	r += fwrite(&header_version, 1, 1, f);
+	r += fwrite(&header_release, 1, 1, f);
+	r += fwrite(&book->date, sizeof book->date, 1, f);
+	r += fwrite(&book->options, sizeof book->options, 1, f);
+	r += fwrite(&book->n_nodes, sizeof book->n_nodes, 1, f);
+
+	ok = (r == 7);
+	foreach_position(p, book) {
+		if (!ok) break;
+		ok = position_write(p, f);
+	}
+	ok = (fclose(f) == 0) && ok;
+
+#ifdef _WIN32
+	if (ok) remove(file);
+#endif
+	if (ok && rename(tmp_file, file) == 0) {
+		remove(journal);
+		foreach_position(p, book) p->checksum = position_checksum(p);
+		book->need_compaction = false;
+		info("done\n");
+	} else {
+		error("\nCannot save book to %s", file);
+		remove(tmp_file);
+	}
+	if (book->snapshot) book_publish(book);
+}
+
+/**
+ * @brief Save the modifications of an opening book.
+ *
+ * The positions added or modified since the book was last saved to the file
+ * are appended to a journal, replayed when the book is loaded. The book is
+ * fully saved instead when the journal does not extend the file (first save,
+ * book saved elsewhere, positions removed) or has grown too big.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ */
+static void book_checkpoint(Book *book, const char *file)
+{
+	unsigned int header_edax = EDAX, header_book = JRNL;
+	unsigned char header_version = VERSION, header_release = RELEASE;
+	char journal[FILENAME_MAX + 1];
+	long book_size = 0, journal_size = 0;
+	uint32_t checksum;
+	Position *p;
+	FILE *f;
+	int n = 0;
+	bool ok;
+
+	book_unmap(book);
+	file_add_ext(file, ".jnl", journal);
+
+	if (book->need_compaction || !book_check_header(book, file, BOOK, &book_size)) {
+		book_save(book, file);
+		return;
+	}
+	if (book_check_header(book, journal, JRNL, &journal_size)) {
+		if (journal_size > book_size / 4) { // compaction
+			book_save(book, file);
+			return;
+		}
+		f = fopen(journal, "ab");
+		ok = (f != NULL);
+	} else {
+		f = fopen(journal, "wb");
+		ok = (f != NULL);
+		ok = ok && fwrite(&header_edax, sizeof (unsigned int), 1, f) == 1;
+		ok = ok && fwrite(&header_book, sizeof (unsigned int), 1, f) == 1;
+		ok = ok && fwrite(&header_version, 1, 1, f) == 1;
+		ok = ok && fwrite(&header_release, 1, 1, f) == 1;
+		ok = ok && fwrite(&book->date, sizeof book->date, 1, f) == 1;
+	}
+
+	info("Saving book journal to %s...", journal);
+	foreach_position(p, book) {
+		if (!ok) break;
+		checksum = position_checksum(p);
+		if (checksum != p->checksum) {
+			ok = position_write(p, f) && fwrite(&checksum, sizeof checksum, 1, f) == 1;
+			p->checksum = checksum;
+			++n;
+		}
+	}
+	if (f) ok = (fclose(f) == 0) && ok;
+
+	if (ok) {
+		info("%d positions done\n", n);
+		if (book->snapshot) book_publish(book);
+	} else {
+		error("\nCannot save book journal to %s", journal);
+		book_save(book, file);
+	}
+}
+
+/**
+ * @brief Replay the journal of an opening book.
+ *
+ * @param book Opening book, just loaded from the file.
+ * @param file File name.
+ */
+static void book_replay(Book *book, const char *file)
+{
+	char journal[FILENAME_MAX + 1];
+	unsigned char header[10 + sizeof book->date];
+	long size, offset;
+	uint32_t checksum;
+	Position p, *q;
+	FILE *f;
+	int n = 0;
+
+	file_add_ext(file, ".jnl", journal);
+	if (!book_check_header(book, journal, JRNL, &size)) return;
+	f = fopen(journal, "rb");
+	if (f == NULL || fread(header, sizeof header, 1, f) != 1) {
+		if (f) fclose(f);
+		return;
+	}
+
+	info("Replaying book journal %s...", journal);
+	for (offset = ftell(f); offset < size; offset = ftell(f)) {
+		if (!position_read(&p, f, &book->arena) || fread(&checksum, sizeof checksum, 1, f) != 1 || checksum != position_checksum(&p)) {
+			warn("incomplete position at the end of %s, ignored\n", journal);
+			position_free(&p, &book->arena);
+			break;
+		}
+		p.checksum = checksum;
+		q = book_probe(book, &p.board);
+		if (q) {
+			position_free(q, &book->arena);
+			*q = p;
+		} else {
+			book_add(book, &p);
+		}
+		++n;
+	}
+	fclose(f);
+
+	if (n) book->need_saving = true;
+	info("%d positions done\n", n);
+}
+
+/**
+ * @brief Save an opening book to be used from its mapped file.
+ *
+ * The positions are saved with their index, so the book can be used as it is
+ * once mapped into memory, without being read.
+ *
+ * @param book Opening book.
+ * @param file File name.
+ */
+void book_save_map(Book *book, const char *file)
+{
+	unsigned char header[BMAP_HEADER_SIZE];
+	BookRecord record;
+	PositionSlot slot;
+	char journal[FILENAME_MAX + 1];
+	Position *p;
+	uint64_t n_links = 0;
+	bool ok;
+	FILE *f;
+	int i;
+
+	book_unmap(book); // the mapped file may be the one to overwrite
+	f = fopen(file, "wb");
+	if (f == NULL) {
+		error("Cannot open file: %s", file);
+		return;
+	}
+
+	info("Saving mapped book to %s...", file);
+	book_set_date(book);
+
+	foreach_position(p, book) n_links += p->n_link;
+	memset(header, 0, sizeof header);
+	put_le(header, EDAX, 4);
+	put_le(header + 4, BMAP, 4);
+	header[8] = VERSION;
+	header[9] = RELEASE;
+	put_le(header + 10, book->date.year, 2);
+	header[12] = book->date.month;
+	header[13] = book->date.day;
+	header[14] = book->date.hour;
+	header[15] = book->date.minute;
+	header[16] = book->date.second;
+	put_le(header + 20, book->options.level, 4);
+	put_le(header + 24, book->options.n_empties, 4);
+	put_le(header + 28, book->options.midgame_error, 4);
+	put_le(header + 32, book->options.endcut_error, 4);
+	put_le(header + 36, book->options.verbosity, 4);
+	put_le(header + 40, book->n_nodes, 4);
+	put_le(header + 44, book->n, 4);
+	put_le(header + 48, n_links, 8);
+
+	ok = (n_links <= UINT_MAX && fwrite(header, sizeof header, 1, f) == 1);
+
+	n_links = 0;
+	foreach_position(p, book) {
+		if (!ok) break;
+		position_to_record(p, &record, (unsigned int) n_links);
+		book_record_le(&record);
+		n_links += p->n_link;
+		ok = (fwrite(&record, sizeof record, 1, f) == 1);
+	}
+
+	for (i = 0; ok && i < book->n; ++i) {
+		slot = book->index[i];
+		position_slot_le(&slot);
+		ok = (fwrite(&slot, sizeof slot, 1, f) == 1);
+	}
+
+	foreach_position(p, book) {
+		if (!ok) break;
+		if (p->n_link) ok = (fwrite(p->link, sizeof (Link), p->n_link, f) == p->n_link);
+	}
+
+	ok = (fclose(f) == 0) && ok;
+
+	if (ok) {
+		file_add_ext(file, ".jnl", journal);
+		remove(journal); // the journal, if any, extends a former book file
+		info("done\n");
+	} else error("\nCannot save book to %s", file);
+}
+
+/**
+ * @brief A read-only copy of an opening book, shared by concurrent readers.
+ *
+ * The copy is laid out as a mapped book file, in a single memory block.
+ */
+typedef struct BookSnapshot {
+	Book book;                 /**< read-only book */
+	BookMap map;               /**< book data */
+	_Atomic int n_users;       /**< readers, plus one while the snapshot is published */
+} BookSnapshot;
+
+/**
+ * @brief Release a book snapshot, and free it if it is no longer used.
+ *
+ * @param snapshot Book snapshot.
+ */
+static void book_snapshot_release(BookSnapshot *snapshot)
+{
+	if (snapshot && atomic_fetch_sub(&snapshot->n_users, 1) == 1) {
+		free(snapshot->map.address);
+		free(snapshot);
 	}
 }
 
 /**
- * @brief Export an opening book.
+ * @brief Publish a snapshot of the opening book to its readers.
  *
- * Save the book in a portable text format.
+ * The book is copied into a new read-only snapshot, that replaces the former
+ * one for the next readers. The former snapshot is freed when its last reader
+ * releases it. Once a first snapshot has been published, a new one is
+ * published each time the book is saved, so the readers follow the book while
+ * it is being extended.
  *
  * @param book Opening book.
- * @param file File name.
  */
-void book_export(Book *book, const char *file)
+void book_publish(Book *book)
 {
-	FILE *f;
-	PositionArray *a;
-	Position *p;
+	BookSnapshot *snapshot, *old;
+	BookRecord *record;
+	PositionSlot *index;
+	Link *link;
+	const Position *p;
+	Position buffer;
+	uint64_t n_links = 0;
+	size_t size;
+	int i;
+	int64_t t = -real_clock();
 
-	f = fopen(file, "w");
-	if (f == NULL) {
-		error("cannot open file %s", file);
+	foreach_position_view(p, i, book, buffer) n_links += p->n_link;
+	size = book->n_nodes * sizeof (BookRecord) + book->n * sizeof (PositionSlot) + n_links * sizeof (Link);
+
+	snapshot = (BookSnapshot*) malloc(sizeof (BookSnapshot));
+	if (snapshot == NULL || (snapshot->map.address = malloc(size + 1)) == NULL || n_links > UINT_MAX) {
+		error("cannot publish the book");
+		if (snapshot) free(snapshot->map.address);
+		free(snapshot);
 		return;
 	}
 
-	info("Exporting book to %s...", file);
-	foreach_position(p, a, book) {
-		if (!position_export(p, f)) {
-			error("cannot export book to %s", file);
-			goto book_export_end;
-		}
+	record = (BookRecord*) snapshot->map.address;
+	index = (PositionSlot*) (record + book->n_nodes);
+	link = (Link*) (index + book->n);
+	n_links = 0;
+	foreach_position_view(p, i, book, buffer) {
+		position_to_record(p, record + i, (unsigned int) n_links);
+		if (p->n_link) memcpy(link + n_links, p->link, p->n_link * sizeof (Link));
+		n_links += p->n_link;
 	}
-	info("done\n");
-
-book_export_end:
-	fclose(f);
+	memcpy(index, book->index, book->n * sizeof (PositionSlot));
+
+	snapshot->map.size = size;
+	snapshot->map.record = record;
+	snapshot->map.link = link;
+	memset(&snapshot->book, 0, sizeof snapshot->book);
+	snapshot->book.date = book->date;
+	snapshot->book.options = book->options;
+	snapshot->book.stats = book->stats;
+	snapshot->book.index = index;
+	snapshot->book.map = &snapshot->map;
+	snapshot->book.n = book->n;
+	snapshot->book.n_nodes = book->n_nodes;
+	atomic_init(&snapshot->n_users, 1);
+
+	spinlock_lock(&book->snapshot_lock);
+	old = book->snapshot;
+	book->snapshot = snapshot;
+	spinlock_unlock(&book->snapshot_lock);
+	book_snapshot_release(old);
+
+	t += real_clock();
+	info("<book published: %d positions in %.3f s>\n", book->n_nodes, 0.001 * t);
 }
 
 /**
- * @brief Save an opening book.
+ * @brief Get a read-only view of the last published snapshot of a book.
  *
- * Save the book in a fast binary format.
+ * The view can be queried (book_get_moves, book_get_game_stats, book_get_line,
+ * etc.) while the book itself is modified by another thread. Each reader uses
+ * its own view, to be released with book_release (and not freed with
+ * book_free).
  *
  * @param book Opening book.
- * @param file File name.
+ * @param view Read-only view.
+ * @return false if no snapshot of the book is published.
  */
-void book_save(Book *book, const char *file)
+bool book_acquire(Book *book, Book *view)
 {
-	unsigned int header_edax = EDAX, header_book = BOOK;
-	unsigned char header_version = VERSION, header_release = RELEASE;
-	FILE *f = fopen(file, "wb");
-	int r;
-	PositionArray *a;
-	Position *p;
+	BookSnapshot *snapshot;
 
-	if (f == NULL) {
-		error("Cannot open file: %s", file);
-		return;
-	}
+	spinlock_lock(&book->snapshot_lock);
+	snapshot = book->snapshot;
+	if (snapshot) atomic_fetch_add(&snapshot->n_users, 1);
+	spinlock_unlock(&book->snapshot_lock);
 
-	info("Saving book to %s...", file);
-	book_set_date(book);
+	if (snapshot == NULL) return false;
 
-	r = fwrite(&header_edax, sizeof (unsigned int), 1, f);
-	r += fwrite(&header_book, sizeof (unsigned int), 1, f);
-	r += fwrite(&header_version, 1, 1, f);
-	r += fwrite(&header_release, 1, 1, f);
-	r += fwrite(&book->date, sizeof book->date, 1, f);
-	r += fwrite(&book->options, sizeof book->options, 1, f);
-	r += fwrite(&book->n_nodes, sizeof book->n_nodes, 1, f);
+	*view = snapshot->book;
+	view->snapshot = snapshot;
+	random_seed(&view->random, real_clock() ^ (uintptr_t) view);
 
-	if (r == 7) {
-		foreach_position(p, a, book) {
-			if (!position_write(p, f)) {
-				error("\nCannot save book to %s", file);
-				goto book_write_end;
-			}
-		}
-	}
-	info("done\n");
+	return true;
+}
 
-book_write_end:
-	fclose(f);
+/**
+ * @brief Release the snapshot held by a book view.
+ *
+ * @param view Book view.
+ */
+void book_release(Book *view)
+{
+	book_snapshot_release(view->snapshot);
+	view->snapshot = NULL;
+}
+
+/**
+ * @brief Add a position with a single best move to a book.
+ *
+ * @param book Opening book.
+ * @param board Position (in its unique form).
+ * @param score Score of the best move.
+ */
+static void book_test_add(Book *book, const Board *board, const int score)
+{
+	Position position;
+
+	position_init(&position);
+	position.board = *board;
+	position.leaf.score = score;
+	position.leaf.move = first_bit(get_moves(board->player, board->opponent));
+	position.score.value = position.score.lower = position.score.upper = score;
+	book_add(book, &position);
+}
+
+/**
+ * @brief Test the book snapshots.
+ *
+ * A reader keeps the view it got while the book is modified & saved. The
+ * next reader gets the saved book.
+ */
+void book_test(void)
+{
+	const char *file = "book_test.dat";
+	char journal[FILENAME_MAX + 1];
+	Book book, view, next;
+	Board init, board, child;
+	MoveList movelist;
+	Position *p;
+
+	book_init(&book);
+	board_init(&init);
+	board_unique(&init, &board);
+	book_test_add(&book, &board, +2);
+	book_publish(&book);
+	expect_eq(book_acquire(&book, &view), true, "book_acquire");
+
+	p = book_probe(&book, &board);
+	p->leaf.score = p->score.value = p->score.lower = p->score.upper = -4;
+	board_next(&board, p->leaf.move, &child);
+	board_unique(&child, &child);
+	book_test_add(&book, &child, +4);
+	book_save(&book, file);
+
+	expect_eq(view.n_nodes, 1, "view kept across book_save");
+	expect_eq(book_get_moves(&view, &board, &movelist), true, "book_get_moves of a view");
+	expect_eq(movelist_first(&movelist)->score, +2, "score of a view kept across book_save");
+	expect_eq(book_get_moves(&view, &child, &movelist), false, "position added after a view");
+
+	expect_eq(book_acquire(&book, &next), true, "book_acquire after book_save");
+	expect_eq(next.n_nodes, 2, "view of the saved book");
+	expect_eq(book_get_moves(&next, &board, &movelist), true, "book_get_moves of the saved book");
+	expect_eq(movelist_first(&movelist)->score, -4, "score of the saved book");
+	expect_eq(book_get_moves(&next, &child, &movelist), true, "position of the saved book");
+
+	book_release(&next);
+	book_release(&view);
+	book_free(&book);
+	file_add_ext(file, ".jnl", journal);
+	remove(file);
+	remove(journal);
+
+	printf("book_test done\n");
 }
 
 /**
@@ -1706,11 +3321,12 @@ book_write_end:
  */
 void book_merge(Book *dest, const Book *src)
 {
-	PositionArray *a;
 	const Position *p_src;
-	Position p_dest;
+	Position p_dest, buffer;
+	int i;
 
-	foreach_position(p_src, a, src) {
+	book_unmap(dest);
+	foreach_position_view(p_src, i, src, buffer) {
 		if (!book_probe(dest, &p_src->board)) {
 			position_merge(&p_dest, p_src);
 			book_add(dest, &p_dest);
@@ -1725,12 +3341,29 @@ void book_merge(Book *dest, const Book *src)
  */
 void book_negamax(Book *book)
 {
-	Position *root = book_root(book);
+	Position *root;
+	BookPass pass = {.book = book};
+	int first[BOOK_PASS_N_LEVELS + 1], *order, k;
+
+	book_unmap(book);
+	root = book_root(book);
 
 	if (root) {
 		bprint("Negamaxing book...");
 		book_clean(book);
-		position_negamax(root, book);
+
+		// mark the positions reachable from the root, then negamax them, level by level
+		order = book_pass_levels(book, first);
+		pass.mark = (_Atomic unsigned char*) calloc(book->n_nodes + 1, sizeof (_Atomic unsigned char));
+		if (pass.mark == NULL) fatal_error("cannot allocate the book marks\n");
+		atomic_init(&pass.count, 0);
+		atomic_store(pass.mark + (root - book->positions), 1);
+		for (k = BOOK_PASS_N_LEVELS - 1; k >= 0; --k) book_pass_run(&pass, position_mark_children, order + first[k], first[k + 1] - first[k]);
+		for (k = 0; k < BOOK_PASS_N_LEVELS; ++k) book_pass_run(&pass, position_negamax_marked, order + first[k], first[k + 1] - first[k]);
+		if (atomic_load(&pass.count)) book->need_saving = true;
+
+		free((void*) pass.mark);
+		free(order);
 		bprint("done\n");
 	}
 }
@@ -1742,18 +3375,38 @@ void book_negamax(Book *book)
  */
 void book_link(Book *book)
 {
-	PositionArray *a;
 	Position *p;
+	BookPass pass = {.book = book};
+	int first[BOOK_PASS_N_LEVELS + 1], *order, k;
 	int i = 0;
 
+	book_unmap(book);
+
 	bprint("Linking book...\r");
-	foreach_position(p, a, book) {
-		position_link(p, book);
+	pass.value = (short*) malloc(book->n_nodes * sizeof (short) + 1);
+	pass.n_link = (unsigned char*) malloc(book->n_nodes + 1);
+	if (pass.value == NULL || pass.n_link == NULL) fatal_error("cannot allocate the book links\n");
+
+	// add the links, all together
+	atomic_init(&pass.count, 0);
+	book_pass_run(&pass, position_link_moves, NULL, book->n_nodes);
+	book->stats.n_links += atomic_load(&pass.count);
+
+	// search the positions without leaf, in the book order
+	foreach_position(p, book) {
 		if (p->leaf.move == NOMOVE) {
 			position_search(p, book);
 		}
 		if (++i % BOOK_INFO_RESOLUTION == 0) bprint("Linking book...%d\r", i);
 	}
+
+	// score the links, level by level
+	order = book_pass_levels(book, first);
+	for (k = 0; k < BOOK_PASS_N_LEVELS; ++k) book_pass_run(&pass, position_link_scores, order + first[k], first[k + 1] - first[k]);
+
+	free(order);
+	free(pass.n_link);
+	free(pass.value);
 	bprint("Linking book...%d done\n", i);
 }
 
@@ -1764,17 +3417,24 @@ void book_link(Book *book)
  */
 void book_fix(Book *book)
 {
-	PositionArray *a;
 	Position *p;
+	BookPass pass = {.book = book};
 	int i = 0;
 
+	book_unmap(book);
+
 	bprint("Fixing book...\r");
-	foreach_position(p, a, book) {
-		if (!position_is_ok(p)) {
+	pass.mark = (_Atomic unsigned char*) calloc(book->n_nodes + 1, sizeof (_Atomic unsigned char));
+	if (pass.mark == NULL) fatal_error("cannot allocate the book marks\n");
+	book_pass_run(&pass, position_check_marked, NULL, book->n_nodes);
+
+	foreach_position(p, book) {
+		if (atomic_load_explicit(pass.mark + (p - book->positions), memory_order_relaxed) && !position_is_ok(p)) {
 			position_fix(p, book);
 			if (++i % BOOK_INFO_RESOLUTION == 0) { bprint("fixing book...%d\r", i);  }
 		}
 	}
+	free((void*) pass.mark);
 	bprint("Fixing book...%d done\n", i);
 }
 
@@ -1787,16 +3447,17 @@ void book_fix(Book *book)
  */
 void book_deepen(Book *book)
 {
-	PositionArray *a;
 	Position *p;
 	int i = 0;
 	uint64_t t = real_clock();
 	char file[FILENAME_MAX + 1];
 
+	book_unmap(book);
+
 	file_add_ext(options.book_file, ".dep", file);
 
 	bprint("Deepening book...\r");
-	foreach_position(p, a, book) {
+	foreach_position(p, book) {
 		int n_empties = board_count_empties(&p->board);
 		if (LEVEL[p->level][n_empties].depth != LEVEL[book->options.level][n_empties].depth
 		 || LEVEL[p->level][n_empties].selectivity != LEVEL[book->options.level][n_empties].selectivity) { // No! compare depth & selectivity;
@@ -1805,8 +3466,8 @@ void book_deepen(Book *book)
 			if (++i % 10 == 0) {
 				bprint("Deepening book...%d\r", i);
 			}
-			if (real_clock() - t > HOUR) {
-				book_save(book, file); // save every hour
+			if (real_clock() - t > BOOK_CHECKPOINT_PERIOD) {
+				book_checkpoint(book, file);
 				t = real_clock();
 			}
 		}
@@ -1823,41 +3484,138 @@ void book_deepen(Book *book)
  */
 void book_correct_solved(Book *book)
 {
-	PositionArray *a;
-	Position *p;
-	int i = 0;
+	Position *p, **solved;
+	BookWorkers workers;
+	int i = 0, j, k, n, n_solved = 0, n_workers;
 	uint64_t t = real_clock();
 	char file[FILENAME_MAX + 1];
-	Link old_leaf;
+	Link *old_leaf;
 	int n_error = 0;
 	char s[4];
 
+	book_unmap(book);
+
 	file_add_ext(options.book_file, ".err", file);
 
 	bprint("Correcting solved positions...\r");
-	foreach_position(p, a, book) {
+	solved = (Position**) malloc(book->n_nodes * sizeof (Position*) + 1);
+	old_leaf = (Link*) malloc(book->n_nodes * sizeof (Link) + 1);
+	if (solved == NULL || old_leaf == NULL) fatal_error("cannot allocate the solved positions\n");
+	foreach_position(p, book) {
 		int n_empties = board_count_empties(&p->board);
 		if (LEVEL[p->level][n_empties].depth == n_empties && LEVEL[p->level][n_empties].selectivity == NO_SELECTIVITY) { // No! compare depth & selectivity;
-			old_leaf = p->leaf;
-			p->leaf = BAD_LINK;
-			position_search(p, book);
-			if (p->leaf.score != old_leaf.score) {
+			solved[n_solved++] = p;
+		}
+	}
+
+	// solve the positions one by one, or several simultaneously
+	n_workers = book_workers_init(&workers) ? workers.n : 0;
+	for (k = 0; k < n_solved; k += n) {
+		n = n_workers ? MIN(16 * n_workers, n_solved - k) : 1;
+		for (j = k; j < k + n; ++j) {
+			old_leaf[j] = solved[j]->leaf;
+			solved[j]->leaf = BAD_LINK;
+		}
+		if (n_workers) book_workers_evaluate(book, &workers, solved + k, n, false);
+		else position_search(solved[k], book);
+
+		for (j = k; j < k + n; ++j) {
+			p = solved[j];
+			if (p->leaf.score != old_leaf[j].score) {
 				++n_error;
 				bprint("\nError found:\n");
 				position_print(p, &p->board, stdout);
-				move_to_string(old_leaf.move, n_empties & 1, s);
-				bprint("instead of <%s:%d>\n\n", s, old_leaf.score);
+				move_to_string(old_leaf[j].move, board_count_empties(&p->board) & 1, s);
+				bprint("instead of <%s:%d>\n\n", s, old_leaf[j].score);
 			}
-			if (++i % 10 == 0 || p->leaf.score != old_leaf.score) {
+			if (++i % 10 == 0 || p->leaf.score != old_leaf[j].score) {
 				bprint("Correcting solved positions...%d (%d error found)\r", i, n_error);
 			}
-			if (real_clock() - t > HOUR) {
-				book_save(book, file); // save every hour
-				t = real_clock();
-			}
+		}
+		if (real_clock() - t > BOOK_CHECKPOINT_PERIOD) {
+			book_checkpoint(book, file);
+			t = real_clock();
 		}
 	}
 	bprint("Correcting solved positions...%d done (%d error found)\n", i, n_error);
+
+	book_workers_free(&workers);
+	free(old_leaf);
+	free(solved);
+}
+
+/**
+ * @brief Expand a book, evaluating several positions simultaneously.
+ *
+ * The positions to expand are processed by chunks. The new children of a
+ * chunk are evaluated first, then their parents, each by one of the workers.
+ * The children are added to the book at the end of the chunk.
+ *
+ * @param book opening book.
+ * @param workers Searches evaluating the positions.
+ * @param action String with a description of current action.
+ * @param tmp_file Temporary file name.
+ */
+static void book_expand_parallel(Book *book, BookWorkers *workers, const char *action, const char *tmp_file)
+{
+	const int chunk = 16 * workers->n;
+	int *todo = (int*) malloc(book->n_nodes * sizeof (int) + 1);
+	Position *child = (Position*) malloc(chunk * sizeof (Position));
+	Position **evaluated = (Position**) malloc(chunk * sizeof (Position*));
+	Position *p;
+	int i = 0, j, k, n, n_todo = 0;
+	uint64_t t = real_clock();
+
+	if (todo == NULL || child == NULL || evaluated == NULL) fatal_error("cannot allocate the positions to expand\n");
+
+	bprint("%s...\r", action);
+
+	for (k = 0; k < book->n_nodes; ++k) if (book->positions[k].todo) todo[n_todo++] = k;
+
+	for (k = 0; k < n_todo; k += chunk) {
+		// new children
+		for (j = n = 0; j < chunk && k + j < n_todo; ++j) {
+			p = book->positions + todo[k + j];
+			if (p->leaf.move != NOMOVE) {
+				position_init(child + n);
+				board_next(&p->board, p->leaf.move, &child[n].board);
+				child[n].level = p->level;
+				position_link(child + n, book);
+				evaluated[n] = child + n;
+				++n;
+			}
+		}
+		book_workers_evaluate(book, workers, evaluated, n, true);
+
+		// parents
+		for (j = n = 0; j < chunk && k + j < n_todo; ++j) {
+			p = book->positions + todo[k + j];
+			if (p->leaf.move != NOMOVE) {
+				p->leaf.score = -child[n].score.value;
+				evaluated[n++] = p;
+			}
+		}
+		book_workers_evaluate(book, workers, evaluated, n, false);
+
+		for (j = 0; j < n; ++j) {
+			position_unique(child + j);
+			book_add(book, child + j);
+		}
+
+		i += MIN(chunk, n_todo - k);
+		bprint("%s...%d/%d done: %d positions, %d links\r", action, i, book->stats.n_todo, book->stats.n_nodes, book->stats.n_links);
+		if (book->search->options.verbosity >= 2) putchar('\n'); else putchar('\r');
+
+		if (real_clock() - t > BOOK_CHECKPOINT_PERIOD) {
+			book_checkpoint(book, tmp_file);
+			t = real_clock();
+		}
+	}
+	bprint("%s...%d/%d done: %d positions, %d links\n", action, i, book->stats.n_todo, book->stats.n_nodes, book->stats.n_links);
+
+	free(evaluated);
+	free(child);
+	free(todo);
 }
 
 /**
@@ -1871,23 +3629,28 @@ void book_correct_solved(Book *book)
  */
 static void book_expand(Book *book, const char *action, const char *tmp_file)
 {
-	PositionArray *a;
 	Position *p;
+	BookWorkers workers;
 	int i = 0, k;
 	uint64_t t = real_clock();
 
+	if (book_workers_init(&workers)) {
+		book_expand_parallel(book, &workers, action, tmp_file);
+		book_workers_free(&workers);
+		return;
+	}
+
 	bprint("%s...\r", action);
 
-	for (a = book->array; a < book->array + book->n; ++a)
-	for (k = 0; k < a->n; ++k) { // do not use foreach_positions here! a->positions may change!
-		p = a->positions + k;
+	for (k = 0; k < book->n_nodes; ++k) { // do not use foreach_positions here! book->positions may change!
+		p = book->positions + k;
 		if (p->todo) {
 			position_expand(p, book);
 			bprint("%s...%d/%d done: %d positions, %d links\r", action, ++i, book->stats.n_todo, book->stats.n_nodes, book->stats.n_links);
 			if (book->search->options.verbosity >= 2) putchar('\n'); else putchar('\r');
 
-			if (real_clock() - t > HOUR) {
-				book_save(book, tmp_file); // save every hour
+			if (real_clock() - t > BOOK_CHECKPOINT_PERIOD) {
+				book_checkpoint(book, tmp_file);
 				t = real_clock();
 			}
 		}
@@ -1902,11 +3665,12 @@ static void book_expand(Book *book, const char *action, const char *tmp_file)
  */
 void book_sort(Book *book)
 {
-	PositionArray *a;
 	Position *p;
 
+	book_unmap(book);
+
 	bprint("Sorting book...");
-	foreach_position(p, a, book) {
+	foreach_position(p, book) {
 		position_sort(p);
 	}
 	bprint("done>\n");
@@ -1920,35 +3684,48 @@ void book_sort(Book *book)
  */
 void book_fill(Book *book, const int depth)
 {
-	PositionArray *a;
 	Position *p;
+	Board board;
+	BookWorkers workers;
+	BoardList boards = {NULL, 0, 0}, *list = NULL;
 	int n_diffs, n_empties, k;
 	char file[FILENAME_MAX + 1];
 
+	book_unmap(book);
+	if (book_workers_init(&workers)) list = &boards;
+
 	file_add_ext(options.book_file, ".fill", file);
 
 	do {
 		n_diffs = 0;
 		book->stats.n_nodes = book->stats.n_links = 0;
-		for (a = book->array; a < book->array + book->n; ++a)
-		for (k = 0; k < a->n; ++k) { // do not use foreach_positions here! a->positions may change!
-			p = a->positions + k;
+		for (k = 0; k < book->n_nodes; ++k) { // do not use foreach_positions here! book->positions may change!
+			p = book->positions + k;
 			n_empties = board_count_empties(&p->board);
 			if (n_empties >= book->options.n_empties) {
-				board_fill(&p->board, book, depth);
+				board = p->board;
+				board_fill(&board, book, depth, list);
+				if (list && (list->n >= 8 * workers.n || k == book->n_nodes - 1)) book_add_boards(book, &workers, list);
 				if (n_diffs < book->stats.n_nodes + book->stats.n_links) {
 					n_diffs = book->stats.n_nodes + book->stats.n_links;
 					bprint("Book fill...%d %d done\r", book->stats.n_nodes, book->stats.n_links);
 				}
 			}
 		}
+		if (list && list->n) {
+			book_add_boards(book, &workers, list);
+			n_diffs = book->stats.n_nodes + book->stats.n_links;
+		}
 		bprint("Book fill...%d %d done\n", book->stats.n_nodes, book->stats.n_links);
 		if (n_diffs) {
 			book_negamax(book);
-			book_save(book, file);
+			book_checkpoint(book, file);
 		}
 	} while (n_diffs);
 	bprint("Book fill... finished\n");
+
+	free(boards.board);
+	book_workers_free(&workers);
 }
 
 /**
@@ -1961,7 +3738,11 @@ void book_fill(Book *book, const int depth)
  */
 void book_deviate(Book *book, const Board *board, const int relative_error, const int absolute_error)
 {
-	Position *root = book_probe(book, board);
+	Position *root;
+
+	book_unmap(book);
+	root = book_probe(book, board);
+
 	if (root) {
 		int score;
 		int n_diffs;
@@ -1982,6 +3763,7 @@ void book_deviate(Book *book, const Board *board, const int relative_error, cons
 			book_expand(book, "Book deviate", file);
 			n_diffs = book->stats.n_nodes + book->stats.n_links;
 
+			root = book_probe(book, board);
 			bprint("Book deviate %d %d:\n", relative_error, absolute_error);
 			book_clean(book);
 			position_deviate(root, book, 0, relative_error, score - absolute_error, score + absolute_error);
@@ -1993,7 +3775,7 @@ void book_deviate(Book *book, const Board *board, const int relative_error, cons
 			root = book_probe(book, board);
 			book_clean(book);
 			position_negamax(root, book);
-			if (n_diffs) book_save(book, file);
+			if (n_diffs) book_checkpoint(book, file);
 		} while (n_diffs);
 		bprint("Book deviate %d %d...finished\n", relative_error, absolute_error);
 	}
@@ -2009,7 +3791,11 @@ void book_deviate(Book *book, const Board *board, const int relative_error, cons
  */
 void book_extend(Book *book, const Board *board)
 {
-	Position *root = book_probe(book, board);
+	Position *root;
+
+	book_unmap(book);
+	root = book_probe(book, board);
+
 	if (root) {
 		int n_diffs;
 		char file[FILENAME_MAX + 1];
@@ -2030,7 +3816,7 @@ void book_extend(Book *book, const Board *board)
 			root = book_probe(book, board);
 			book_clean(book);
 			position_negamax(root, book);
-			if (n_diffs) book_save(book, file);
+			if (n_diffs) book_checkpoint(book, file);
 		} while (n_diffs);
 		bprint("Book extend... finished\n");
 	}
@@ -2044,7 +3830,11 @@ void book_extend(Book *book, const Board *board)
  */
 void book_play(Book *book, const Board *board)
 {
-	Position *root = book_probe(book, board);
+	Position *root;
+
+	book_unmap(book);
+	root = book_probe(book, board);
+
 	if (root) {
 		int n_diffs;
 		char file[FILENAME_MAX + 1];
@@ -2065,7 +3855,7 @@ void book_play(Book *book, const Board *board)
 			root = book_probe(book, board);
 			book_clean(book);
 			position_negamax(root, book);
-			if (n_diffs) book_save(book, file);
+			if (n_diffs) book_checkpoint(book, file);
 		} while (n_diffs);
 		bprint("Book play... finished\n");
 	}
@@ -2082,11 +3872,13 @@ void book_play(Book *book, const Board *board)
  */
 void book_prune(Book *book)
 {
-	PositionArray *a;
 	Position *p;
-	Position *root = book_root(book);
+	Position *root;
 	int i;
 
+	book_unmap(book);
+	root = book_root(book);
+
 	if (root) {
 		book_clean(book);
 		position_negamax(root, book);
@@ -2098,9 +3890,8 @@ void book_prune(Book *book)
 
 		position_prune(root, book, 0, 2*SCORE_INF, -SCORE_INF, SCORE_INF);
 		bprint("Book prune %d... done\n", book->stats.n_todo);
-		for (a = book->array; a < book->array + book->n; ++a)
-		for (i = 0; i < a->n; ++i) if (!a->positions[i].done) {book_remove(book, a->positions + i); --i;}
-		foreach_position(p, a, book) position_remove_links(p, book);
+		for (i = 0; i < book->n_nodes; ++i) if (!book->positions[i].done) {book_remove(book, book->positions + i); --i;}
+		foreach_position(p, book) position_remove_links(p, book);
 		bprint("done\n");
 	}
 }
@@ -2114,11 +3905,13 @@ void book_prune(Book *book)
  */
 void book_subtree(Book *book, const Board *board)
 {
-	PositionArray *a;
 	Position *p;
-	Position *root = book_probe(book, board);
+	Position *root;
 	int i;
 
+	book_unmap(book);
+	root = book_probe(book, board);
+
 	if (root) {
 		book_clean(book);
 		position_negamax(root, book);
@@ -2127,9 +3920,8 @@ void book_subtree(Book *book, const Board *board)
 		position_prune(root, book, 2*SCORE_INF, 2*SCORE_INF, -SCORE_INF, SCORE_INF);
 		position_print(root, &root->board, stdout);
 		bprint("Book subtree %d... done\n", book->stats.n_todo);
-		for (a = book->array; a < book->array + book->n; ++a)
-		for (i = 0; i < a->n; ++i) if (!a->positions[i].done) {book_remove(book, a->positions + i); --i;}
-		foreach_position(p, a, book) position_remove_links(p, book);
+		for (i = 0; i < book->n_nodes; ++i) if (!book->positions[i].done) {book_remove(book, book->positions + i); --i;}
+		foreach_position(p, book) position_remove_links(p, book);
 		bprint("done\n");
 	}
 }
@@ -2145,7 +3937,11 @@ void book_subtree(Book *book, const Board *board)
  */
 void book_enhance(Book *book, Board *board, const int midgame_error, const int endcut_error)
 {
-	Position *root = book_probe(book, board);
+	Position *root;
+
+	book_unmap(book);
+	root = book_probe(book, board);
+
 	if (root) {
 		int n_diffs;
 		char file[FILENAME_MAX + 1];
@@ -2168,7 +3964,7 @@ void book_enhance(Book *book, Board *board, const int midgame_error, const int e
 			root = book_probe(book, board);
 			book_clean(book);
 			position_negamax(root, book);
-			if (n_diffs) book_save(book, file);
+			if (n_diffs) book_checkpoint(book, file);
 		} while (n_diffs);
 		bprint("Book enhance %d %d...finished\n", midgame_error, endcut_error);
 	}
@@ -2181,15 +3977,16 @@ void book_enhance(Book *book, Board *board, const int midgame_error, const int e
  */
 void book_info(Book *book)
 {
-	PositionArray *a;
-	Position *p;
+	const Position *p;
+	Position buffer;
 	uint64_t n_links = 0;
 	uint64_t n_leaves = 0;
 	uint64_t n_level[61] = {0};
-	int min_array = book->n_nodes, max_array = 0;
-	int i;
+	uint64_t n_probes = 0;
+	int max_probes = 0;
+	int i, d;
 
-	foreach_position(p, a, book) {
+	foreach_position_view(p, i, book, buffer) {
 		n_links += p->n_link;
 		if (p->leaf.move != NOMOVE) ++n_leaves;
 		++n_level[p->level];
@@ -2198,9 +3995,10 @@ void book_info(Book *book)
 		}
 	}
 
-	for (a = book->array; a < book->array + book->n; ++a) {
-		if (a->n > max_array) max_array = a->n;
-		if (a->n < min_array) min_array = a->n;
+	for (i = 0; i < book->n; ++i) if (book->index[i].i >= 0) {
+		d = book_probe_length(book, i);
+		n_probes += d;
+		if (d > max_probes) max_probes = d;
 	}
 
 	bprint("Edax Book %d.%d; ", VERSION, RELEASE);
@@ -2213,8 +4011,16 @@ void book_info(Book *book)
 		}
 	}
 	bprint("Depth: %d\n", 61 - book->options.n_empties);
-	bprint("Memory occupation: %ld\n", (int64_t) (book->n_nodes * sizeof (Position) + book->n * sizeof (PositionArray) + n_links * sizeof (Link)));
-	bprint("Hash balance: %d < %d < %d\n", min_array, (int) (book->n_nodes / book->n), max_array);
+	if (book->map) bprint("Memory occupation: %ld (mapped file)\n", (int64_t) book->map->size);
+	else {
+		const int64_t positions_size = book->size * sizeof (Position);
+		const int64_t index_size = book->n * sizeof (PositionSlot);
+		const int64_t links_size = link_arena_size(&book->arena);
+		const int64_t size = positions_size + index_size + links_size;
+		bprint("Memory occupation: %ld (positions %ld + index %ld + links %ld); %.1f bytes per position\n",
+			size, positions_size, index_size, links_size, book->n_nodes ? (double) size / book->n_nodes : 0.0);
+	}
+	bprint("Hash index: %d slots; %.2f probes per position (max = %d)\n", book->n, book->n_nodes ? (double) n_probes / book->n_nodes : 0.0, max_probes);
 }
 
 /**
@@ -2226,7 +4032,8 @@ void book_info(Book *book)
 void book_show(Book *book, Board *board)
 {
 	GameStats stat = {0,0,0,0};
-	Position *position = book_probe(book, board);
+	Position buffer;
+	const Position *position = book_view(book, board, &buffer);
 	uint64_t n_games;
 
 	if (position) {
@@ -2251,7 +4058,8 @@ void book_show(Book *book, Board *board)
  */
 bool book_get_moves(Book *book, const Board *board, MoveList *movelist)
 {
-	Position *position = book_probe(book, board);
+	Position buffer;
+	const Position *position = book_view(book, board, &buffer);
 	if (position) {
 		position_get_moves(position, board, movelist);
 		return true;
@@ -2270,14 +4078,15 @@ bool book_get_moves(Book *book, const Board *board, MoveList *movelist)
  */
 void book_get_line(Book *book, const Board *board, const Move *move, Line *line)
 {
-	Position *position;
+	const Position *position;
+	Position buffer;
 	Board b;
 	Move m;
 
 	line_push(line, move->x);
 	board_next(board, move->x, &b);
 
-	while ((position = book_probe(book, &b)) != NULL && !board_is_game_over(&position->board)) {
+	while ((position = book_view(book, &b, &buffer)) != NULL && !board_is_game_over(&position->board)) {
 		position_get_random_move(position, &b, &m, &book->random, 0);
 		line_push(line, m.x);
 		board_update(&b, &m);
@@ -2298,7 +4107,8 @@ void book_get_line(Book *book, const Board *board, const Move *move, Line *line)
 #else
 bool book_get_random_move(Book *book, const Board *board, Move *move, const int randomness)
 {
-	Position *position = book_probe(book, board);
+	Position buffer;
+	const Position *position = book_view(book, board, &buffer);
 	if (position) {
 		position_get_random_move(position, board, move, &book->random, randomness);
 		return true;
@@ -2317,7 +4127,8 @@ bool book_get_random_move(Book *book, const Board *board, Move *move, const int
  */
 void book_get_game_stats(Book *book, const Board *board, GameStats *stat)
 {
-	Position *position;
+	const Position *position;
+	Position buffer;
 
 	assert(book != NULL);
 	assert(board !=NULL);
@@ -2325,11 +4136,11 @@ void book_get_game_stats(Book *book, const Board *board, GameStats *stat)
 
 	stat->n_wins = stat->n_losses = stat->n_draws = stat->n_lines = 0;
 
-	position = book_probe(book, board);
+	position = book_view(book, board, &buffer);
 	if (position) {
 		if (position->n_wins == UINT_MAX || position->n_losses == UINT_MAX || position->n_draws == UINT_MAX || position->n_lines == UINT_MAX) {
 			Board target;
-			Link *l;
+			const Link *l;
 			GameStats child;
 
 			foreach_link(l, position) {
@@ -2361,6 +4172,8 @@ void book_add_board(Book *book, const Board *board)
 	Position position;
 	Position *probe;
 
+	book_unmap(book);
+
 	if (board_count_empties(board) >= book->options.n_empties - 1) {
 		probe = book_probe(book, board);
 		if (probe) {
@@ -2418,38 +4231,191 @@ void book_add_game(Book *book, const Game *game)
 		board_restore(&board, stack + n_moves);
 	}
 
-	if (book->stats.n_nodes + book->stats.n_links > n_stats && book_get_age(book) > 3600) book_save(book, file);
+	if (book->stats.n_nodes + book->stats.n_links > n_stats && book_get_age(book) > 3600) book_checkpoint(book, file);
+}
+
+/**
+ * @brief Positions of a chunk of games, gathered by several threads.
+ */
+typedef struct BookImport {
+	BookPass pass;                /**< pass over the games */
+	const Game *game;             /**< games */
+	Board *board;                 /**< positions of the games, by slots of n_plies boards */
+	unsigned char *n_boards;      /**< number of positions of each game */
+	int n_plies;                  /**< maximal number of positions of a game */
+} BookImport;
+
+/**
+ * @brief Gather the positions of a game to add to the book.
+ *
+ * These are the positions added by book_add_game(), as unique boards.
+ *
+ * @param pass Book import (cast as a book pass).
+ * @param i Game index.
+ */
+static void book_import_game(BookPass *pass, const int i)
+{
+	BookImport *import = (BookImport*) pass;
+	const Game *game = import->game + i;
+	Board board, *unique = import->board + (size_t) i * import->n_plies;
+	Move move;
+	int j, n = 0;
+
+	board_init(&board);
+	if (board_equal(&board, &game->initial_board)) { // skip non standard game
+		for (j = 0; j < 60 - pass->book->options.n_empties && game->move[j] != NOMOVE; ++j) {
+			if (!can_move(board.player, board.opponent)) {
+				board_pass(&board);
+				board_unique(&board, unique + n++);
+			}
+			if (!board_is_occupied(&board, game->move[j]) && board_get_move(&board, game->move[j], &move)) {
+				board_update(&board, &move);
+				board_unique(&board, unique + n++);
+			} else {
+				warn("illegal move in game");
+				break; // stop, illegal moves
+			}
+		}
+	}
+	import->n_boards[i] = n;
+}
+
+/**
+ * @brief Compare two boards by their number of empty squares, then by their discs.
+ */
+static int board_import_cmp(const void *a, const void *b)
+{
+	const Board *x = (const Board*) a;
+	const Board *y = (const Board*) b;
+	const int d = board_count_empties(x) - board_count_empties(y);
+
+	if (d) return d;
+	if (x->player != y->player) return x->player < y->player ? -1 : 1;
+	if (x->opponent != y->opponent) return x->opponent < y->opponent ? -1 : 1;
+	return 0;
+}
+
+/**
+ * @brief Merge sorted unique boards into a sorted list of unique boards.
+ *
+ * @param list Board list.
+ * @param board Boards to merge.
+ * @param n Number of boards to merge.
+ */
+static void board_list_merge(BoardList *list, const Board *board, const int n)
+{
+	Board *merged = (Board*) malloc((list->n + n) * sizeof (Board) + 1);
+	int i = 0, j = 0, k = 0, c;
+
+	if (merged == NULL) fatal_error("cannot allocate the boards to add to the book\n");
+	while (i < list->n && j < n) {
+		c = board_import_cmp(list->board + i, board + j);
+		if (c < 0) merged[k++] = list->board[i++];
+		else {
+			if (c == 0) ++i;
+			merged[k++] = board[j++];
+		}
+	}
+	while (i < list->n) merged[k++] = list->board[i++];
+	while (j < n) merged[k++] = board[j++];
+
+	free(list->board);
+	list->board = merged;
+	list->n = k;
+	list->size = list->n + n;
 }
 
 /**
  * @brief Add positions from a game database.
  *
+ * The games are processed by chunks: their positions are gathered by several
+ * threads, sorted & deduplicated, then merged into the list of all the unique
+ * positions of the base. These positions are eventually added to the book
+ * once each, by increasing number of empties, several at a time with the
+ * -batch search workers. The book modifications are regularly checkpointed
+ * meanwhile, so a long import can resume from the last checkpoint.
+ *
+ * As every position is added after all the positions following it, it is
+ * linked to its children from any game, transpositions included. The book
+ * thus has the same positions as when adding the games one by one, but a
+ * superset of their links: the values of the positions may change through
+ * these extra links, and a leaf may be another move of equal score.
+ *
  * @param book opening book.
  * @param base games to add.
  */
 void book_add_base(Book *book, const Base *base)
 {
-	int i;
+	BookImport import;
+	BookWorkers workers;
+	BoardList list = {NULL, 0, 0}, chunk;
 	char file[FILENAME_MAX + 1];
-	int64_t t0, t;
+	int i, j, k, m, n;
+	int64_t n_boards = 0, t0, t, t_save;
+	bool has_workers;
 
 	file_add_ext(options.book_file, ".gam", file);
 
 	book_clean(book);
 	bprint("Adding %d games to book...\n", base->n_games);
-	t0 = real_clock();
-	for (i = 0; i < base->n_games; ++i) {
-		book_add_game(book, base->game + i);
+
+	import.pass.book = book;
+	import.n_plies = 2 * (60 - book->options.n_empties) + 1;
+	import.board = (Board*) malloc((size_t) BOOK_IMPORT_CHUNK * import.n_plies * sizeof (Board));
+	import.n_boards = (unsigned char*) malloc(BOOK_IMPORT_CHUNK);
+	if (import.board == NULL || import.n_boards == NULL) fatal_error("cannot allocate the positions of the games\n");
+
+	for (i = 0; i < base->n_games; i += n) {
+		n = MIN(BOOK_IMPORT_CHUNK, base->n_games - i);
+		import.game = base->game + i;
+		book_pass_run(&import.pass, book_import_game, NULL, n);
+
+		for (j = k = 0; j < n; ++j) {
+			memmove(import.board + k, import.board + (size_t) j * import.n_plies, import.n_boards[j] * sizeof (Board));
+			k += import.n_boards[j];
+		}
+		n_boards += k;
+		qsort(import.board, k, sizeof (Board), board_import_cmp);
+		for (j = m = MIN(k, 1); j < k; ++j) {
+			if (board_import_cmp(import.board + m - 1, import.board + j)) import.board[m++] = import.board[j];
+		}
+		board_list_merge(&list, import.board, m);
+		bprint("Gathering positions...%d/%d games: %d positions\r", i + n, base->n_games, list.n);
+	}
+	bprint("Gathering positions...%d/%d games: %d positions (%" PRId64 " in games)\n", i, base->n_games, list.n, n_boards);
+	free(import.board);
+	free(import.n_boards);
+
+	// add the positions by small batches, to show the progress & checkpoint the book between them
+	has_workers = book_workers_init(&workers);
+	if (has_workers) qsort(list.board, list.n, sizeof (Board), board_empties_cmp);
+	else search_cleanup(book->search);
+	t0 = t_save = real_clock();
+	for (i = 0; i < list.n; i += n) {
+		if (has_workers) {
+			chunk.board = list.board + i;
+			chunk.n = n = MIN(8 * workers.n, list.n - i);
+			chunk.size = 0;
+			book_add_boards(book, &workers, &chunk);
+		} else {
+			n = 1;
+			book_add_board(book, list.board + i);
+		}
 		t = real_clock();
 		if (t - t0 > 1000) {
-		    bprint("Adding games...%d/%d done: %d positions, %d links\r", i + 1, base->n_games, book->stats.n_nodes, book->stats.n_links);
+			bprint("Adding positions...%d/%d done: %d positions, %d links\r", i + n, list.n, book->stats.n_nodes, book->stats.n_links);
 			t0 = t;
 		}
-		if (book->search->options.verbosity) putchar('\n');
-
+		if (t - t_save > BOOK_CHECKPOINT_PERIOD) {
+			book_checkpoint(book, file);
+			t_save = real_clock();
+		}
 	}
-	bprint("Adding games...%d/%d done: %d positions, %d links\n", i, base->n_games, book->stats.n_nodes, book->stats.n_links);
-	bprint("%d games added to book\n", i);
+	book_workers_free(&workers);
+	free(list.board);
+
+	bprint("Adding positions...done: %d positions, %d links\n", book->stats.n_nodes, book->stats.n_links);
+	bprint("%d games added to book\n", base->n_games);
 
 	book_save(book, file);
 }
@@ -2609,15 +4575,15 @@ void book_extract_skeleton(Book *book, Base *base)
  */
 void book_extract_positions(Book *book, const int n_empties, const int n_positions)
 {
-	PositionArray *a;
-	Position *p;
+	const Position *p;
+	Position buffer;
 	MoveList movelist;
 	Move *best, *second_best;
-	int i = 0;
+	int i = 0, k;
 	char s[80];
 
 	bprint("Extracting %d positions at %d ...\n", n_positions, n_empties);
-	foreach_position(p, a, book) {
+	foreach_position_view(p, k, book, buffer) {
 		if (i == n_positions) break;
 		if (board_count_empties(&p->board) == n_empties) {
 			position_get_moves(p, &p->board, &movelist);
@@ -2638,6 +4604,127 @@ void book_extract_positions(Book *book, const int n_empties, const int n_positio
 	}
 }
 
+/**
+ * @brief Check if the score of a position is missing.
+ *
+ * The score is missing when some moves are neither linked nor evaluated by the
+ * leaf, or when a game-over position was never scored.
+ *
+ * @param position Position.
+ * @return true if the position needs a search to be scored.
+ */
+static bool position_is_unscored(const Position *position)
+{
+	const int n_moves = get_mobility(position->board.player, position->board.opponent);
+
+	if (position->leaf.move != NOMOVE) return false;
+	return position->n_link < n_moves || (position->n_link == 0 && n_moves == 0 && position->score.value == -SCORE_INF);
+}
+
+/**
+ * @brief Write a position in OBF format, with the score of its book moves.
+ *
+ * @param position Position.
+ * @param f Output stream.
+ * @return true if the position is written.
+ */
+static bool position_write_obf(const Position *position, FILE *f)
+{
+	MoveList movelist;
+	const Move *m;
+	char s[80];
+
+	board_to_string(&position->board, board_count_empties(&position->board) & 1, s);
+	fprintf(f, "%s;", s);
+	position_get_moves(position, &position->board, &movelist);
+	foreach_move(m, &movelist) {
+		putc(' ', f);
+		move_print(m->x, 0, f);
+		fprintf(f, ":%+d;", m->score);
+	}
+	if (movelist.n_moves == 0) fprintf(f, " %+d;", position->score.value);
+
+	return putc('\n', f) != EOF;
+}
+
+/**
+ * @brief Export book positions to train an evaluation function.
+ *
+ * The positions between <min_empties> and <max_empties> are streamed, chunk by
+ * chunk, to OBF files, with the score of all their book moves. Positions with a
+ * missing score are first evaluated, several at a time with the -batch search
+ * workers. The positions of each number of empties can be written into their
+ * own file (<file>.<empties>), created when its first position is exported.
+ *
+ * @param book Opening book.
+ * @param file Output file name.
+ * @param min_empties Minimal number of empties.
+ * @param max_empties Maximal number of empties.
+ * @param shard Write a file per number of empties.
+ */
+void book_export_positions(Book *book, const char *file, const int min_empties, const int max_empties, const bool shard)
+{
+	FILE *f[61] = {NULL};
+	Position **chunk, **missing, *p;
+	BookWorkers workers;
+	char name[FILENAME_MAX + 16], ext[8];
+	int i, j, k, n, n_missing, n_workers, n_empties;
+	int n_exported = 0, n_scored = 0;
+	bool ok = true;
+	int64_t t = -real_clock();
+
+	book_unmap(book);
+
+	chunk = (Position**) malloc(2 * BOOK_EXPORT_CHUNK * sizeof (Position*));
+	if (chunk == NULL) fatal_error("cannot allocate the positions to export\n");
+	missing = chunk + BOOK_EXPORT_CHUNK;
+	n_workers = book_workers_init(&workers) ? workers.n : 0;
+
+	bprint("Exporting positions...\r");
+	for (k = 0; k < book->n_nodes && ok; k = i) {
+		for (i = k, n = n_missing = 0; i < book->n_nodes && n < BOOK_EXPORT_CHUNK; ++i) {
+			p = book->positions + i;
+			n_empties = board_count_empties(&p->board);
+			if (n_empties < min_empties || n_empties > max_empties) continue;
+			chunk[n++] = p;
+			if (position_is_unscored(p)) missing[n_missing++] = p;
+		}
+
+		if (n_workers) book_workers_evaluate(book, &workers, missing, n_missing, false);
+		else for (j = 0; j < n_missing; ++j) position_search(missing[j], book);
+
+		for (j = 0; j < n && ok; ++j) {
+			n_empties = shard ? board_count_empties(&chunk[j]->board) : 0;
+			if (f[n_empties] == NULL) {
+				if (shard) {
+					sprintf(ext, ".%02d", n_empties);
+					file_add_ext(file, ext, name);
+				} else strcpy(name, file);
+				if ((f[n_empties] = fopen(name, "w")) == NULL) {
+					error("cannot open file %s", name);
+					ok = false;
+					break;
+				}
+			}
+			ok = position_write_obf(chunk[j], f[n_empties]);
+		}
+		n_exported += n;
+		n_scored += n_missing;
+		bprint("Exporting positions...%d (%d scored)\r", n_exported, n_scored);
+	}
+
+	for (n_empties = 0; n_empties <= 60; ++n_empties) {
+		if (f[n_empties] && fclose(f[n_empties]) != 0) ok = false;
+	}
+	if (!ok) error("\ncannot export the positions to %s", file);
+
+	book_workers_free(&workers);
+	free(chunk);
+
+	t += real_clock();
+	bprint("Exporting positions...%d (%d scored) in %.1f s (%.0f positions/s)\n", n_exported, n_scored, 0.001 * t, t > 0 ? 1000.0 * n_exported / t : 0.0);
+}
+
 /**
  * @brief print book statistics.
  *
@@ -2645,9 +4732,9 @@ void book_extract_positions(Book *book, const int n_empties, const int n_positio
  */
 void book_stats(Book *book)
 {
-	PositionArray *a;
-	Position *p;
-	int i;
+	const Position *p;
+	Position buffer;
+	int i, k;
 	uint64_t n_hash[256];
 	uint64_t n_pos[61], n_leaf[61], n_link[61], n_terminal[61];
 	uint64_t n_score[129];
@@ -2656,18 +4743,17 @@ void book_stats(Book *book)
 
 	printf("\nHash distribution:\n");
 	for (i = 0; i < 256; ++i) n_hash[i] = 0;
-	for (a = book->array; a < book->array + book->n; ++a) {
-		if (a->n < 256) ++n_hash[a->n];
-		else ++n_hash[255];
+	for (i = 0; i < book->n; ++i) if (book->index[i].i >= 0) {
+		++n_hash[MIN(book_probe_length(book, i), 255)];
 	}
-	printf("index    positions\n");
+	printf("probes   positions\n");
 	for (i = 0; i < 255; ++i) if (n_hash[i]) printf("%5d %12" PRIu64 "\n", i, n_hash[i]);
 	if (n_hash[i]) printf(">%4d %12" PRIu64 "\n", i - 1, n_hash[i]);
 
 	printf("\nStage distribution:\n");
 	printf("stage    positions        links       leaves      terminal nodes\n");
 	for (i = 0; i < 61; ++i) n_pos[i] = n_leaf[i] = n_link[i] = n_terminal[i] = 0;
-	foreach_position(p, a, book) {
+	foreach_position_view(p, k, book, buffer) {
 		i = board_count_empties(&p->board);
 		++n_pos[i];
 		if (p->leaf.move != NOMOVE) ++n_leaf[i];
@@ -2679,7 +4765,7 @@ void book_stats(Book *book)
 	printf("\nBest Score Distribution:\n");
 	printf("Score    positions\n");
 	for (i = 0; i < 129; ++i) n_score[i] = 0;
-	foreach_position(p, a, book) {
+	foreach_position_view(p, k, book, buffer) {
 		++n_score[64 + p->score.value];
 	}
 	for (i = 0; i < 129; ++i) if (n_score[i]) printf("%+5d %12" PRIu64 "\n", i - 64, n_score[i]);
@@ -2690,11 +4776,25 @@ void book_stats(Book *book)
 /**
  * @brief feed hash table from the opening book.
  *
+ * Each reachable book position is fed once, the deepest positions first.
+ *
  * @param book Opening book.
  * @param board Position to start from.
  * @param search HashTables container.
+ * @param depth Maximal number of moves to walk from the position.
+ * @param n_max Maximal number of positions to feed.
  */
-void book_feed_hash(const Book *book, Board *board, Search *search)
+void book_feed_hash(const Book *book, Board *board, Search *search, const int depth, const int n_max)
 {
-	board_feed_hash(board, book, search, true);
+	FeedSet set = {NULL, 0, 0, n_max};
+	int64_t t = -real_clock();
+
+	info("Feeding hash from the book...");
+	board_feed_hash(board, book, search, true, depth, &set);
+	t += real_clock();
+	if (options.info) {
+		fprintf(stderr, "%d positions in ", set.n); time_print(t, false, stderr);
+		fprintf(stderr, " (%.0f positions/s)\n", set.n * 1000.0 / (t + 1));
+	}
+	free(set.slot);
 }
@@ -18,6 +18,18 @@
 #include "util.h"
 #include <stdbool.h>
 
+/**
+ * struct LinkArena
+ * @brief Storage of the linking moves of the book positions.
+ */
+typedef struct LinkArena {
+	char **chunk;          /**< allocated memory chunks */
+	int n_chunks;          /**< number of memory chunks */
+	char *top, *end;       /**< unused memory of the last chunk */
+	void *free[5];         /**< freed blocks of links, by size class */
+	SpinLock lock;         /**< lock */
+} LinkArena;
+
 /**
  * struct Book
  * @brief The opening book.
@@ -41,12 +53,19 @@ typedef struct Book {
 		int n_todo;
 	} stats;
 	Random random;
-	struct PositionArray *array;
+	struct Position *positions;
+	struct PositionSlot *index;
+	struct BookMap *map;
 	struct PositionStack* stack;
+	LinkArena arena;
+	struct BookSnapshot *snapshot;
+	SpinLock snapshot_lock;
 	Search *search;
 	int n;
+	int size;
 	int n_nodes;
 	bool need_saving;
+	bool need_compaction;
 } Book;
 
 /**
@@ -66,6 +85,7 @@ void book_free(Book*);
 void book_new(Book*, int, int);
 void book_load(Book*, const char*);
 void book_save(Book*, const char*);
+void book_save_map(Book*, const char*);
 void book_import(Book*, const char*);
 void book_export(Book*, const char*);
 void book_merge(Book*, const Book*);
@@ -98,8 +118,14 @@ void book_check_base(Book*, const Base*);
 
 void book_extract_skeleton(Book*, Base*);
 void book_extract_positions(Book*, const int, const int);
+void book_export_positions(Book*, const char*, const int, const int, const bool);
+
+void book_publish(Book*);
+bool book_acquire(Book*, Book*);
+void book_release(Book*);
+void book_test(void);
 
-void book_feed_hash(const Book*, Board*, Search*);
+void book_feed_hash(const Book*, Board*, Search*, const int, const int);
 
 #endif /* EDAX_BOOK_H */
 
@@ -71,7 +71,7 @@
  *
  * Game DataBase Commands:
  *   -convert [file_in] [file_out]     convert between different format.
- *   -unique [file_in] [file_out]      remove doublons in the base.
+ *   -unique [file_in] [file_out] [sym]  remove doublons (& symetric games) in the base.
  *   -check [file_in] [n]              check error in the last <n> moves.
  *   -correct [file_in] [n]            correct error in the last <n> moves.
  *   -complete [file_in]               complete a database by playing the last missing moves.
@@ -81,6 +81,7 @@
  *   -solve [file]        solve a set of positions.
  *   -obftest [file]      Test from an obf file.
  *   -script-to-obf [file]Convert a script to an obf file.
+ *   -obf-convert [file_in] [file_out] Convert a text obf file to binary, or back.
  *   -wtest [file]        check the theoric scores of a wthor base file.
  *   -count games [d]     compute the number of moves from the current position up\n  to depth [d].
  *   -perft [d]           same as above, but without hash table.
@@ -228,6 +229,8 @@ void help_book(void)
 		"  load [file]          load an opening book from a binary opening file.\n"
 		"  merge [file]         merge an opening book with the current opening book.\n"
 		"  save [file]          save an opening book to a binary opening file.\n"
+		"  map [file]           save an opening book to a file usable without loading\n" SPACES "(memory mapped). Load it with 'book load'.\n"
+		"  publish              play from a read-only copy of the book, updated each time\n" SPACES "the book is saved or loaded.\n"
 		"  import [file]        load an opening book from a portable text file.\n"
 		"  export [file]        save an opening book to a portable text file.\n"
 		"  on                   use the opening book.\n"
@@ -247,6 +250,8 @@ void help_book(void)
 		"  extend               add positions by expanding leaves with a best score.\n"
 		"  prune                remove unreachable positions.\n"
 		"  subtree              only keep positions from the current position.\n"
+		"  export-positions <file> [n1] [n2] [shard]\n" SPACES "export the positions with <n1> to <n2> empties & the\n" SPACES "score of their moves to an OBF file (or a file per\n" SPACES "number of empties), to train an evaluation function.\n"
+		"  feed-hash [n1] [n2]  feed the hash tables from the book, up to <n1> moves from\n" SPACES "the current position & <n2> positions.\n"
 		"  add [file]           a dd positions from a game base file (txt, ggf, sgf or\n" SPACES "wthor format).\n");
 }
 
@@ -257,11 +262,13 @@ void help_base(void)
 {
 	printf("\nGame DataBase :\n"
 		"  convert [file_in] [file_out]     convert between different format.\n"
-		"  unique [file_in] [file_out]      remove doublons in the base.\n"
+		"  unique [file_in] [file_out] [sym] remove doublons (& symetric games with\n" SPACES "sym) in the base.\n"
 		"  check [file_in] [n]              check error in the last <n> moves.\n"
 		"  correct [file_in] [n]            correct error in the last <n> moves.\n"
 		"  complete [file_in]               complete a database by playing the last\n" SPACES "missing moves.\n"
-		"  problem [file_in] [n] [file_out] build a set of problems from a game\n" SPACES "database with <n> empties.\n");
+		"  problem [file_in] [n] [file_out] build a set of problems from a game\n" SPACES "database with <n> empties.\n"
+		"  index [file_in] [file_out]       index the positions of a game database.\n"
+		"  games [index_file] [n]           list <n> games of an indexed database\n" SPACES "through the current position.\n");
 }
 
 /**
@@ -273,6 +280,7 @@ void help_test(void)
 		"  bench               test edax speed.\n"
 		"  obftest [file]      Test from an obf file.\n"
 		"  script-to-obf [file]Convert a script to an obf file.\n"
+		"  obf-convert [file_in] [file_out] Convert a text obf file to binary, or back.\n"
 		"  wtest [file]        check the theoric scores of a wthor base file.\n"
 		"  count games [d]     compute the number of moves from the current position up\n" SPACES "to depth [d].\n"
 		"  perft [d]           same as above, but without hash table.\n"
@@ -487,6 +495,13 @@ void ui_loop_edax(UI *ui)
 				parse_word(hard_file, hard_file, FILENAME_MAX);
 				obf_filter(full_file, hard_file);
 
+			// convert a text .obf file to a binary one, or back
+			} else if (strcmp(cmd, "obf-convert") == 0) {
+				char input_file[FILENAME_MAX + 1], *output_file;
+				output_file = parse_word(param, input_file, FILENAME_MAX);
+				parse_word(output_file, output_file, FILENAME_MAX);
+				obf_convert(input_file, output_file);
+
 			// game/position enumeration
 			} else if (strcmp(cmd, "count") == 0) {
 				char count_cmd[16], *count_param;
@@ -638,6 +653,7 @@ void ui_loop_edax(UI *ui)
 			} else if (strcmp(cmd, "book") == 0 || strcmp(cmd, "b") == 0) {
 				char book_cmd[FILENAME_MAX + 1], *book_param;
 				int val_1, val_2;
+				bool is_published;
 				Book *book = play->book;
 
 				book->search = &play->search;
@@ -670,22 +686,36 @@ void ui_loop_edax(UI *ui)
 				} else if (strcmp(book_cmd, "new") == 0) {
 					val_1 = 21; book_param = parse_int(book_param, &val_1);
 					val_2 = 36;	book_param = parse_int(book_param, &val_2);
+					is_published = (book->snapshot != NULL);
 					book_free(book) ;
 					book_new(book, val_1, 61 - val_2);
+					if (is_published) book_publish(book);
 
 				// load an opening book (binary format) from the disc
 				} else if (strcmp(book_cmd, "load") == 0 || strcmp(book_cmd, "open") == 0) {
+					is_published = (book->snapshot != NULL);
 					book_free(book) ;
 					parse_word(book_param, book_file, FILENAME_MAX);
 					book_load(book, book_file);
+					if (is_published) book_publish(book);
 
 				// save an opening book (binary format) to the disc
 				} else if (strcmp(book_cmd, "save") == 0) {
 					parse_word(book_param, book_file, FILENAME_MAX);
 					book_save(book, book_file);
 
+				// save an opening book (memory mapped format) to the disc
+				} else if (strcmp(book_cmd, "map") == 0) {
+					parse_word(book_param, book_file, FILENAME_MAX);
+					book_save_map(book, book_file);
+
+				// play from a read-only snapshot of the book, published again at each save
+				} else if (strcmp(book_cmd, "publish") == 0) {
+					book_publish(book);
+
 				// import an opening book (text format)
 				} else if (strcmp(book_cmd, "import") == 0) {
+					is_published = (book->snapshot != NULL);
 					book_free(book);
 					parse_word(book_param, book_file, FILENAME_MAX);
 					book_import(book, book_file);
@@ -693,6 +723,7 @@ void ui_loop_edax(UI *ui)
 					book_fix(book);
 					book_negamax(book);
 					book_sort(book);
+					if (is_published) book_publish(book);
 
 				// export an opening book (text format)
 				} else if (strcmp(book_cmd, "export") == 0) {
@@ -792,6 +823,15 @@ void ui_loop_edax(UI *ui)
 					val_2 = 10; book_param = parse_int(book_param, &val_2); BOUND(val_2, 1, 1000000, "number of positions");
 					book_extract_positions(book, val_1, val_2);
 
+				// export positions to train an evaluation function
+				} else if (strcmp(book_cmd, "export-positions") == 0) {
+					char shard[FILENAME_MAX];
+					book_param = parse_word(book_param, book_file, FILENAME_MAX);
+					val_1 = 0; book_param = parse_int(book_param, &val_1); BOUND(val_1, 0, 60, "number of empties");
+					val_2 = 60; book_param = parse_int(book_param, &val_2); BOUND(val_2, val_1, 60, "number of empties");
+					parse_word(book_param, shard, FILENAME_MAX);
+					book_export_positions(book, book_file, val_1, val_2, strcmp(shard, "shard") == 0);
+
 				// extract pv to a game database
 				} else if (strcmp(book_cmd, "extract") == 0) {
 					Base base;
@@ -832,7 +872,9 @@ void ui_loop_edax(UI *ui)
 
 				// add book positions to the hash table
 				} else if (strcmp(book_cmd, "feed-hash") == 0) {
-					book_feed_hash(book, &play->board, &play->search);
+					val_1 = 60; book_param = parse_int(book_param, &val_1); BOUND(val_1, 0, 60, "feed-hash depth");
+					val_2 = INT_MAX; book_param = parse_int(book_param, &val_2); BOUND(val_2, 1, INT_MAX, "feed-hash positions");
+					book_feed_hash(book, &play->board, &play->search, val_1, val_2);
 
 				// wrong command ?
 				} else {
@@ -858,8 +900,7 @@ void ui_loop_edax(UI *ui)
 					base_param = parse_int(base_param, &n_empties);
 					base_param = parse_word(base_param, problem_file, FILENAME_MAX);
 
-					base_load(&base, base_file);
-					base_to_problem(&base, n_empties, problem_file);
+					base_to_problem(base_file, n_empties, problem_file);
 
 				// extract FEN
 				} else if (strcmp(base_cmd, "tofen") == 0) {
@@ -868,8 +909,7 @@ void ui_loop_edax(UI *ui)
 					base_param = parse_int(base_param, &n_empties);
 					base_param = parse_word(base_param, problem_file, FILENAME_MAX);
 
-					base_load(&base, base_file);
-					base_to_FEN(&base, n_empties, problem_file);
+					base_to_FEN(base_file, n_empties, problem_file);
 
 				// correct erroneous games
 				} else if (strcmp(base_cmd, "correct") == 0) {
@@ -886,8 +926,7 @@ void ui_loop_edax(UI *ui)
 					int n_empties = 24;
 					base_param = parse_int(base_param, &n_empties);
 
-					base_load(&base, base_file);
-					base_analyze(&base, &play->search, n_empties, false);
+					base_check(base_file, &play->search, n_empties);
 
 				// terminate unfinished base
 				} else if (strcmp(base_cmd, "complete") == 0) {
@@ -898,17 +937,35 @@ void ui_loop_edax(UI *ui)
 
 				// convert a base to another format
 				} else if (strcmp(base_cmd, "convert") == 0) {
-					base_load(&base, base_file);
-					base_param = parse_word(base_param, base_file, FILENAME_MAX);
-					base_save(&base, base_file);
+					char base_file_2[FILENAME_MAX + 1];
+					base_param = parse_word(base_param, base_file_2, FILENAME_MAX);
+					base_convert(base_file, base_file_2);
 
 				// make a base unique by removing identical games
 				} else if (strcmp(base_cmd, "unique") == 0) {
+					char symetric[FILENAME_MAX + 1];
 					base_load(&base, base_file);
 					base_param = parse_word(base_param, base_file, FILENAME_MAX);
-					base_unique(&base);
+					base_param = parse_word(base_param, symetric, FILENAME_MAX);
+					base_unique(&base, strcmp(symetric, "sym") == 0);
 					base_save(&base, base_file);
 
+				// index the positions of a game base
+				} else if (strcmp(base_cmd, "index") == 0) {
+					char index_file[FILENAME_MAX + 1];
+					base_param = parse_word(base_param, index_file, FILENAME_MAX);
+					base_index_build(base_file, index_file);
+
+				// list the games through the current position
+				} else if (strcmp(base_cmd, "games") == 0) {
+					BaseIndex index;
+					int n_max = 20;
+					base_param = parse_int(base_param, &n_max);
+					if (base_index_open(&index, base_file)) {
+						base_index_print(&index, &play->board, n_max, stdout);
+						base_index_close(&index);
+					}
+
 				// compare two game bases
 				} else if (strcmp(base_cmd, "compare") == 0) {
 					char base_file_2[FILENAME_MAX + 1];
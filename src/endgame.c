@@ -465,6 +465,7 @@ int NWS_endgame(Search *search, const int alpha)
 	int score, bestscore, bestmove;
 	uint64_t cost;
 
+	search_check_timeout(search);
 	if (search->stop) return alpha;
 
 	assert(search->n_empties == bit_count(~(search->board.player | search->board.opponent)));
@@ -799,6 +799,25 @@ void eval_set(Eval *eval, const Board *board)
 	}
 }
 
+/**
+ * @brief Copy the current evaluation features.
+ *
+ * Only the features of the current ply are copied, as the features of the
+ * earlier plies are never accessed by the destination.
+ *
+ * @param dest  Destination evaluation function.
+ * @param src   Source evaluation function.
+ */
+void eval_copy(Eval *dest, const Eval *src)
+{
+	assert(dest != NULL && dest->feature != NULL);
+	assert(src != NULL && src->feature != NULL);
+
+	dest->player = src->player;
+	dest->ply = src->ply;
+	dest->feature[dest->ply] = src->feature[src->ply];
+}
+
 /**
  * @brief Swap player's feature.
  *
@@ -49,6 +49,7 @@ void eval_free(Eval*);
 void eval_open(const char*);
 void eval_close(void);
 void eval_set(Eval*, const struct Board*);
+void eval_copy(Eval*, const Eval*);
 void eval_update(Eval*, const struct Move*);
 void eval_restore(Eval*);
 void eval_pass(Eval*);
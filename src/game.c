@@ -30,6 +30,35 @@ enum {
 	PARSE_INVALID_VALUE = 3
 };
 
+/**
+ * @brief Read a character from a game source.
+ *
+ * @param src Game source.
+ * @return The character, or EOF.
+ */
+static inline int game_source_getc(GameSource *src)
+{
+	int c;
+
+	if (src->f) c = getc(src->f);
+	else c = (src->s < src->end) ? (unsigned char) *src->s++ : EOF;
+	if (c == EOF) src->eof = true;
+
+	return c;
+}
+
+/**
+ * @brief Push back the last character read from a game source.
+ *
+ * @param c Character.
+ * @param src Game source.
+ */
+static inline void game_source_ungetc(int c, GameSource *src)
+{
+	if (src->f) ungetc(c, src->f);
+	else if (c != EOF) --src->s;
+}
+
 /**
  * @brief Coordinates conversion from wthor to edax.
  *
@@ -450,7 +479,42 @@ void game_write(const Game *game, FILE *f)
  */
 void game_import_text(Game *game, FILE *f)
 {
-	char *line = string_read_line(f);
+	GameSource src = {.f = f};
+
+	game_import_text_source(game, &src);
+}
+
+/**
+ * @brief Read a game from a text source
+ *
+ * @param game The output game.
+ * @param src The game source.
+ */
+void game_import_text_source(Game *game, GameSource *src)
+{
+	char *line;
+	const char *s;
+	size_t n;
+
+	if (src->f) {
+		line = string_read_line(src->f);
+		src->eof = feof(src->f);
+	} else if (src->s >= src->end) {
+		line = NULL;
+		src->eof = true;
+	} else {
+		s = (const char*) memchr(src->s, '\n', src->end - src->s);
+		if (s == NULL) {
+			s = src->end;
+			src->eof = true;
+		}
+		n = s - src->s;
+		line = (char*) malloc(n + 1);
+		if (line == NULL) fatal_error("Allocation error\n");
+		memcpy(line, src->s, n);
+		line[n] = '\0';
+		src->s = (s < src->end) ? s + 1 : s;
+	}
 
 	if (line) text_to_game(line, game);
 	else  game_init(game);
@@ -522,11 +586,11 @@ void game_import_oko(Game *game, FILE *f)
  *
  * From the current input stream, fill a tag/value pair.
  *
- * @param f The file stream.
+ * @param src The game source.
  * @param tag The tag field.
  * @param value The value field.
  */
-static int game_parse_ggf(FILE *f, char *tag, char *value)
+static int game_parse_ggf(GameSource *src, char *tag, char *value)
 {
 	int i, c='\0';
 
@@ -534,7 +598,7 @@ static int game_parse_ggf(FILE *f, char *tag, char *value)
 	value[0] = '\0';
 
 	for (i = 0; i < 3; i++) {
-		c=fgetc(f);
+		c=game_source_getc(src);
 		if (c==EOF) return PARSE_END_OF_FILE;
 		else  if (c==' ' || c=='\n' || c=='\r' || c=='\t') {
 			i--;
@@ -544,7 +608,7 @@ static int game_parse_ggf(FILE *f, char *tag, char *value)
 		else if ('A' <= c && c <= 'Z') tag[i] = (char)c;
 		else if (i == 0 && (c == '(' || c == ';')) {
  			tag[0] = (char)c;
- 			c = fgetc(f);
+ 			c = game_source_getc(src);
 			if ((tag[0] == '(' && c == ';') || (tag[0] == ';' && c == ')')) {
 				tag[1] = (char)c;
 				tag[2] = '\0';
@@ -556,7 +620,7 @@ static int game_parse_ggf(FILE *f, char *tag, char *value)
 	tag[i] = '\0';
 
 	for (i = 0; i < 1000; i++) {
-		c = fgetc(f);
+		c = game_source_getc(src);
 		if (c == EOF) return PARSE_END_OF_FILE;
 		if (c == ']') break;
 		value[i] = tolower(c);
@@ -565,7 +629,7 @@ static int game_parse_ggf(FILE *f, char *tag, char *value)
 
 	if (i == 1000) {
 		for (i = 0; ; i++) {
-			c = fgetc(f);
+			c = game_source_getc(src);
 			if (c == EOF) return PARSE_END_OF_FILE;
 			if (c == ']') break;
 		}
@@ -580,14 +644,27 @@ static int game_parse_ggf(FILE *f, char *tag, char *value)
  * @param f The file stream.
  */
 void game_import_ggf(Game* game, FILE* f)
+{
+	GameSource src = {.f = f};
+
+	game_import_ggf_source(game, &src);
+}
+
+/**
+ * @brief Read a game from a Generic Game Format (ggf) source.
+ *
+ * @param game The output game.
+ * @param src The game source.
+ */
+void game_import_ggf_source(Game* game, GameSource *src)
 {
 	char tag[4], value[1000];
 	int i = 0;
 
 	game_init(game);
-	while (game_parse_ggf(f, tag, value) != PARSE_END_OF_FILE && strcmp(tag, "(;") != 0) ;
+	while (game_parse_ggf(src, tag, value) != PARSE_END_OF_FILE && strcmp(tag, "(;") != 0) ;
 	if (strcmp(tag, "(;") == 0) {
-		while (game_parse_ggf(f, tag, value) == PARSE_OK) {
+		while (game_parse_ggf(src, tag, value) == PARSE_OK) {
 			if (strcmp(tag,";)")==0) {
 				if (!game_check(game)) {
 					warn("error while importing a GGF game\n");
@@ -616,7 +693,7 @@ void game_import_ggf(Game* game, FILE* f)
 				i++;
 			}
 		}
-		while (game_parse_ggf(f, tag, value) != PARSE_END_OF_FILE && strcmp(tag,";)") != 0) ;
+		while (game_parse_ggf(src, tag, value) != PARSE_END_OF_FILE && strcmp(tag,";)") != 0) ;
 	}
 	return;
 }
@@ -758,11 +835,11 @@ void game_export_ggf(const Game *game, FILE *f)
  *
  * From the current input stream, fill a tag/value pair.
  *
- * @param f The file stream.
+ * @param src The game source.
  * @param tag The tag field.
  * @param value The value field.
  */
-static int game_parse_sgf(FILE *f, char *tag, char *value)
+static int game_parse_sgf(GameSource *src, char *tag, char *value)
 {
 	int i, c = '\0';
 
@@ -770,7 +847,7 @@ static int game_parse_sgf(FILE *f, char *tag, char *value)
 	value[0] = '\0';
 
 	for (i = 0; i < 3; i++) {
-		c = fgetc(f);
+		c = game_source_getc(src);
 		if (c == EOF) return 0;
 		 else  if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ';') {
 			i--;
@@ -790,11 +867,11 @@ static int game_parse_sgf(FILE *f, char *tag, char *value)
 	tag[i] = '\0';
 
 	for (i = 0; i < 1000; i++) {
-		c = fgetc(f);
+		c = game_source_getc(src);
 		if (c == EOF) return 0;
 		if (c == ']') break;
 		if (c == '\\') {
-			c = fgetc(f);
+			c = game_source_getc(src);
 			if (c == EOF) return 0;
 		}
 		value[i] = (char)c;
@@ -804,10 +881,10 @@ static int game_parse_sgf(FILE *f, char *tag, char *value)
 		value[i] = '\0';
 	} else {
 		for (i = 0; ; i++) {
-			c = fgetc(f);
+			c = game_source_getc(src);
 			if (c == EOF) return 0;
 			if (c == '\\') {
-				c = fgetc(f);
+				c = game_source_getc(src);
 				if (c == EOF) return 0;
 			}
 			if (c == ']') break;
@@ -824,14 +901,27 @@ static int game_parse_sgf(FILE *f, char *tag, char *value)
  * @param f The file stream.
  */
 void game_import_sgf(Game *game, FILE *f)
+{
+	GameSource src = {.f = f};
+
+	game_import_sgf_source(game, &src);
+}
+
+/**
+ * @brief Read a game from a sgf source.
+ *
+ * @param game The output game.
+ * @param src The game source.
+ */
+void game_import_sgf_source(Game *game, GameSource *src)
 {
 	char tag[4], value[1000];
 	int i = 0, level = 1;
 
-	game_parse_sgf(f, tag, value);
+	game_parse_sgf(src, tag, value);
 	game_init(game);
 	if (strcmp(tag, "(") == 0) {
-		while (game_parse_sgf(f, tag, value)) {
+		while (game_parse_sgf(src, tag, value)) {
 			if (strcmp(tag,"(") == 0) level++;
 			if (strcmp(tag,")") == 0) {
 				level--;
@@ -855,7 +945,7 @@ void game_import_sgf(Game *game, FILE *f)
 
 			}
 		}
-		while (level > 0 && game_parse_sgf(f, tag, value)) {
+		while (level > 0 && game_parse_sgf(src, tag, value)) {
 			if (strcmp(tag,"(") == 0) level++;
 			if (strcmp(tag,")") == 0) level--;
 		}
@@ -956,6 +1046,19 @@ void game_export_sgf(const Game *game, FILE *f)
  * @param f The file stream.
  */
 void game_import_pgn(Game *game, FILE *f)
+{
+	GameSource src = {.f = f};
+
+	game_import_pgn_source(game, &src);
+}
+
+/**
+ * @brief Read a game from a pgn source.
+ *
+ * @param game The output game.
+ * @param src The game source.
+ */
+void game_import_pgn_source(Game *game, GameSource *src)
 {
 	int c, state, i, j, k, n;
 	char move[5] = "--\0\0";
@@ -983,13 +1086,12 @@ void game_import_pgn(Game *game, FILE *f)
 	state = STATE_START;
 	i = j = k = 0;
 	while(state != STATE_END_GAME) {
-		c = getc(f);
-		putchar(c);
+		c = game_source_getc(src);
 		if  (c == EOF) {
 			state = STATE_END_GAME;
 		}  else  if  (c == '{') { // skip comments
 			do {
-				c = getc(f);
+				c = game_source_getc(src);
 			} while(c != EOF && c != '}');
 		}  else  if  (c == '[') {
 			switch(state) {
@@ -1000,7 +1102,7 @@ void game_import_pgn(Game *game, FILE *f)
 				break;
 			case STATE_END_MOVE:
 			case STATE_END_SCORE:
-				ungetc(c, f);
+				game_source_ungetc(c, src);
 				state = STATE_END_GAME;
 				break;
 			default:
@@ -1549,7 +1651,7 @@ int game_analyze(Game *game, Search *search, const int n_empties, const bool app
 	int i;
 
 	search->options.verbosity = 0;
-	search_cleanup(search);
+	if (!search->options.keep_date) search_cleanup(search);
 	board = game->initial_board;
 	player = game->player;
 	for (i = n_move = 0; i < 60 && game->move[i] != NOMOVE; ++i) {
@@ -1633,7 +1735,7 @@ int game_complete(Game *game, Search *search)
 	int player;
 
 	search->options.verbosity = 0;
-	search_cleanup(search);
+	if (!search->options.keep_date) search_cleanup(search);
 
 	player = game->player;
 	for (n = 0; n < 60; ++n) {
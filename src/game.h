@@ -49,6 +49,14 @@ typedef struct OkoGame {
 	uint8_t move[61];
 } OkoGame;
 
+/** Characters of a game file, read from a stream or from memory */
+typedef struct GameSource {
+	FILE *f;            /**< file stream (or NULL to read from memory) */
+	const char *s;      /**< next character in memory */
+	const char *end;    /**< end of the characters in memory */
+	bool eof;           /**< set once reading past the end */
+} GameSource;
+
 /* function declarations */
 void game_init(Game*);
 void game_copy(Game*, const Game*);
@@ -75,6 +83,10 @@ void game_export_wthor(const Game*, FILE*);
 void game_export_eps(const Game*, FILE *);
 void game_export_svg(const Game*, FILE *);
 void game_import_oko(Game*, FILE*);
+void game_import_text_source(Game*, GameSource*);
+void game_import_ggf_source(Game*, GameSource*);
+void game_import_sgf_source(Game*, GameSource*);
+void game_import_pgn_source(Game*, GameSource*);
 void game_import_gam(Game*, FILE *);
 void game_rand(Game*, int, struct Random*);
 int game_analyze(Game*, struct Search*, const int, const bool);
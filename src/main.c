@@ -115,6 +115,7 @@ int main(int argc, char **argv)
 	options_bound();
 
 	// initialize
+	cpu_topology_init();
 	edge_stability_init();
 	statistics_init();
 	eval_open(options.eval_file);
@@ -145,6 +146,7 @@ int main(int argc, char **argv)
 		// TODO: add more complete unit test
 		bit_test();
 		board_test();
+		book_test();
 	} else if (ui->type == UI_CASSIO) {
 		engine_loop();
 
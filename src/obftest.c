@@ -13,6 +13,10 @@
  * by a colon: 'move':'score'. </li>
  * </ul>
  *
+ * A binary OBF file starts with a header, followed by fixed-size records
+ * holding the board, the player on turn and the scored moves of a position.
+ * Comments are not kept in binary files. Integers are stored in little-endian
+ * order, whatever the host.
  *
  * @date 1998 - 2024
  * @author Richard Delorme
@@ -27,6 +31,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 /** OBF structure: Othello Board File */
 typedef struct OBF {
@@ -41,6 +46,33 @@ typedef struct OBF {
 	char *comments;   /**<! Array of comments */
 } OBF;
 
+/** tag of the binary OBF file format */
+#define OBFB 0x4f424642
+
+/**
+ * Header size of a binary OBF file:
+ * EDAX tag (4 bytes), OBFB tag (4), version (1), release (1), unused (6).
+ */
+#define OBF_HEADER_SIZE 16
+
+/**
+ * Record size of a binary OBF file:
+ * player's discs (8 bytes), opponent's discs (8), player on turn (1),
+ * move number (1), position score (1), unused (1),
+ * MAX_MOVE moves as coordinate (1) & score (1), unused (2).
+ */
+#define OBF_RECORD_SIZE 88
+
+/** Reader of a text or binary OBF file */
+typedef struct OBFReader {
+	FILE *f;                  /**<! text file (or NULL) */
+	void *map;                /**<! mapped binary file (or NULL) */
+	size_t size;              /**<! mapped file size */
+	const unsigned char *record; /**<! binary records */
+	int n;                    /**<! number of binary records */
+	int i;                    /**<! next binary record */
+} OBFReader;
+
 /** OBF parse status */
 enum {
 	OBF_PARSE_OK,
@@ -152,16 +184,179 @@ static int obf_read(OBF *obf, FILE *f)
 }
 
 /**
- * @brief Analyze an OBF structure.
- * @param search Search.
+ * @brief Convert an OBF structure to a binary record.
  * @param obf OBF structure.
- * @param n position number.
+ * @param record Binary record (OBF_RECORD_SIZE bytes).
  */
-static void obf_search(Search *search, OBF *obf, int n)
+static void obf_to_record(const OBF *obf, unsigned char *record)
 {
-	int i, j;
-	bool bad_move = false, bad_score = false;
+	int i;
+
+	memset(record, 0, OBF_RECORD_SIZE);
+	put_le(record, obf->board.player, 8);
+	put_le(record + 8, obf->board.opponent, 8);
+	record[16] = (unsigned char) obf->player;
+	record[17] = (unsigned char) obf->n_moves;
+	record[18] = (unsigned char) obf->best_score;
+	for (i = 0; i < obf->n_moves; ++i) {
+		record[20 + 2 * i] = (unsigned char) obf->move[i].x;
+		record[21 + 2 * i] = (unsigned char) obf->move[i].score;
+	}
+}
+
+/**
+ * @brief Convert a binary record to an OBF structure.
+ *
+ * The record is checked as a text position would be when parsed: the discs
+ * must not overlap, the player on turn must be BLACK or WHITE and the moves
+ * must be on the board or a pass.
+ *
+ * @param record Binary record (OBF_RECORD_SIZE bytes).
+ * @param obf OBF structure.
+ * @return true if the record is valid.
+ */
+static bool obf_from_record(const unsigned char *record, OBF *obf)
+{
+	int i;
 
+	obf->board.player = get_le(record, 8);
+	obf->board.opponent = get_le(record + 8, 8);
+	obf->player = record[16];
+	obf->n_moves = record[17];
+	obf->best_score = (signed char) record[18];
+	obf->comments = NULL;
+	if ((obf->board.player & obf->board.opponent) || obf->player > WHITE || obf->n_moves > MAX_MOVE) return false;
+
+	for (i = 0; i < obf->n_moves; ++i) {
+		obf->move[i].x = record[20 + 2 * i];
+		obf->move[i].score = (signed char) record[21 + 2 * i];
+		if (obf->move[i].x > PASS) return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Write the header of a binary OBF file.
+ * @param f Output stream.
+ */
+static void obf_write_header(FILE *f)
+{
+	unsigned char header[OBF_HEADER_SIZE];
+
+	memset(header, 0, sizeof header);
+	put_le(header, EDAX, 4);
+	put_le(header + 4, OBFB, 4);
+	header[8] = VERSION;
+	header[9] = RELEASE;
+	fwrite(header, sizeof header, 1, f);
+}
+
+/**
+ * @brief Write an OBF structure as a binary record.
+ * @param obf OBF structure.
+ * @param f Output stream.
+ */
+static void obf_write_record(const OBF *obf, FILE *f)
+{
+	unsigned char record[OBF_RECORD_SIZE];
+
+	obf_to_record(obf, record);
+	fwrite(record, sizeof record, 1, f);
+}
+
+/**
+ * @brief Open a text or binary OBF file.
+ *
+ * A binary file is read from a memory map. A binary file of another version
+ * is refused, and an incomplete last record is ignored with a warning.
+ *
+ * @param reader OBF reader.
+ * @param file OBF file.
+ * @return true if the file is opened.
+ */
+static bool obf_reader_open(OBFReader *reader, const char *file)
+{
+	const unsigned char *header;
+
+	memset(reader, 0, sizeof *reader);
+	reader->map = file_map(file, &reader->size);
+	if (reader->map && reader->size >= OBF_HEADER_SIZE) {
+		header = (const unsigned char*) reader->map;
+		if (get_le(header, 4) == EDAX && get_le(header + 4, 4) == OBFB) {
+			if (header[8] != VERSION) {
+				warn("%s: unsupported binary OBF version %d\n", file, header[8]);
+				file_unmap(reader->map, reader->size);
+				reader->map = NULL;
+				return false;
+			}
+			reader->record = header + OBF_HEADER_SIZE;
+			reader->n = (reader->size - OBF_HEADER_SIZE) / OBF_RECORD_SIZE;
+			if ((reader->size - OBF_HEADER_SIZE) % OBF_RECORD_SIZE) {
+				warn("%s: truncated binary OBF file, only %d complete records read\n", file, reader->n);
+			}
+			return true;
+		}
+	}
+	file_unmap(reader->map, reader->size);
+	reader->map = NULL;
+
+	reader->f = fopen(file, "r");
+	return reader->f != NULL;
+}
+
+/**
+ * @brief Read the next OBF structure from a text or binary OBF file.
+ * @param reader OBF reader.
+ * @param obf OBF structure.
+ * @return Parsing status.
+ */
+static int obf_reader_next(OBFReader *reader, OBF *obf)
+{
+	if (reader->f) return obf_read(obf, reader->f);
+	if (reader->i >= reader->n) {
+		obf->comments = NULL;
+		return OBF_PARSE_END;
+	}
+	if (!obf_from_record(reader->record + reader->i++ * (size_t) OBF_RECORD_SIZE, obf)) {
+		warn("invalid binary OBF record %d\n", reader->i);
+		return OBF_PARSE_SKIP;
+	}
+	return OBF_PARSE_OK;
+}
+
+/**
+ * @brief Close an OBF reader.
+ * @param reader OBF reader.
+ */
+static void obf_reader_close(OBFReader *reader)
+{
+	if (reader->f) fclose(reader->f);
+	file_unmap(reader->map, reader->size);
+	reader->f = NULL;
+	reader->map = NULL;
+}
+
+/** OBF test statistics */
+typedef struct OBFTally {
+	uint64_t n_nodes;   /**<! searched nodes */
+	int64_t time;       /**<! search time */
+	int64_t cpu_time;   /**<! cpu time */
+	int n;              /**<! number of positions */
+	int n_bad_score;    /**<! number of erroneous scores */
+	int n_bad_move;     /**<! number of erroneous moves */
+	double score_error; /**<! cumulated absolute score error */
+	double move_error;  /**<! cumulated absolute move error */
+	bool is_solving;    /**<! all positions are solved */
+} OBFTally;
+
+/**
+ * @brief Set up the search of an OBF structure.
+ * @param search Search.
+ * @param obf OBF structure.
+ */
+static void obf_setup(Search *search, OBF *obf)
+{
 	search_cleanup(search);
 	search_set_board(search, &obf->board, obf->player);
 	search_set_level(search, options.level, search->n_empties);
@@ -170,30 +365,33 @@ static void obf_search(Search *search, OBF *obf, int n)
 
 	if (options.play_type == EDAX_TIME_PER_MOVE) search_set_move_time(search, options.time);
 	else search_set_game_time(search, options.time);
+}
 
-	if (options.verbosity >= 2) {
-		printf("\n*** problem # %d ***\n\n", n);
-		board_print(&search->board, search->player, stdout);
-		putchar('\n');
-		puts(search->options.header);
-		puts(search->options.separator);
-	} else if (options.verbosity == 1) printf("%3d|", n);
-
-	search_run(search);
+/**
+ * @brief Check the result of an OBF structure search.
+ * @param obf OBF structure.
+ * @param result Search result.
+ * @param is_solving The search solved the position.
+ * @param separator Separator line to print (or NULL).
+ */
+static void obf_check(OBF *obf, Result *result, const bool is_solving, const char *separator)
+{
+	int i, j;
+	bool bad_move = false, bad_score = false;
 
 	for (i = 0; i < obf->n_moves; ++i) {
-		if (obf->move[i].x == search->result->move) break;
+		if (obf->move[i].x == result->move) break;
 	}
 
 	if (obf->best_score != -SCORE_INF && i < obf->n_moves) {
-		bad_score = obf->best_score != search->result->score;
+		bad_score = obf->best_score != result->score;
 		bad_move = obf->move[i].score != obf->best_score;
 	}
 
 	// show bad move/score (always when solving)
-	if (options.verbosity || (search_is_solving(search) && (bad_move || bad_score))) {
+	if (options.verbosity || (is_solving && (bad_move || bad_score))) {
 		if (options.verbosity <= 1) {
-			result_print(search->result, stdout);
+			result_print(result, stdout);
 		}
 		if (bad_move) {
 			printf(" Erroneous move: ");
@@ -208,13 +406,236 @@ static void obf_search(Search *search, OBF *obf, int n)
 			printf(" Erroneous score: %+d expected", obf->best_score);
 		}
 		putchar('\n');
-		if (options.verbosity >= 2) {
-			puts(search->options.separator);
+		if (options.verbosity >= 2 && separator) {
+			puts(separator);
 		}
 		fflush(stdout);
 	}
 }
 
+/**
+ * @brief Analyze an OBF structure.
+ * @param search Search.
+ * @param obf OBF structure.
+ * @param n position number.
+ */
+static void obf_search(Search *search, OBF *obf, int n)
+{
+	obf_setup(search, obf);
+
+	if (options.verbosity >= 2) {
+		printf("\n*** problem # %d ***\n\n", n);
+		board_print(&search->board, search->player, stdout);
+		putchar('\n');
+		puts(search->options.header);
+		puts(search->options.separator);
+	} else if (options.verbosity == 1) printf("%3d|", n);
+
+	search_run(search);
+
+	obf_check(obf, search->result, search_is_solving(search), search->options.separator);
+}
+
+/**
+ * @brief Add the result of an OBF structure search to the statistics.
+ * @param tally OBF test statistics.
+ * @param obf OBF structure.
+ * @param result Search result.
+ * @param w OBF file with position wrongly analyzed (or NULL).
+ */
+static void obf_tally_add(OBFTally *tally, OBF *obf, const Result *result, FILE *w)
+{
+	int i;
+
+	++tally->n;
+	tally->n_nodes += result->n_nodes;
+	for (i = 0; i < obf->n_moves; ++i) {
+		if (obf->move[i].x == result->move) break;
+	}
+	if (i < obf->n_moves) {
+		if (obf->move[i].score < obf->best_score) ++tally->n_bad_move;
+		if (obf->move[i].score != result->score) ++tally->n_bad_score;
+		tally->move_error += abs(obf->best_score - obf->move[i].score);
+		if (w && obf->move[i].score < obf->best_score) obf_write(obf, w);
+	}
+	if (obf->best_score > -SCORE_INF) tally->score_error += abs(obf->best_score - result->score);
+}
+
+/**
+ * @brief Print the OBF test statistics.
+ * @param tally OBF test statistics.
+ * @param obf_file OBF file.
+ */
+static void obf_tally_print(const OBFTally *tally, const char *obf_file)
+{
+	printf("%.30s: ", obf_file);
+	if (tally->n_nodes) printf("%" PRIu64 " nodes in ", tally->n_nodes);
+	time_print(tally->time, false, stdout);
+	printf(" (cpu = ");
+	time_print(tally->cpu_time, false, stdout);
+	if (tally->time > 0 && tally->n_nodes > 0) printf(") (%8.0f nodes/s).", 1000.0 * tally->n_nodes / tally->time);
+	putchar('\n');
+
+	if ((options.verbosity >= 1 || tally->is_solving) && (tally->n_bad_move + tally->n_bad_score > 0)) {
+		printf("%d positions; ", tally->n);
+		printf("%d erroneous move; ", tally->n_bad_move);
+		printf("%d erroneous score; ", tally->n_bad_score);
+		printf("mean absolute score error = %.3f; ", tally->score_error / tally->n);
+		printf("mean absolute move error = %.3f\n", tally->move_error / tally->n);
+	}
+}
+
+/** Problems of an OBF file solved simultaneously */
+typedef struct OBFBatch {
+	OBF *obf;           /**<! problems */
+	const unsigned char *record; /**<! problems of a binary file, loaded by the searches (or NULL) */
+	Result *result;     /**<! problem results */
+	bool *is_solving;   /**<! problem solved? */
+	bool *is_valid;     /**<! problem loaded? */
+	bool *is_done;      /**<! problem done? */
+	int n;              /**<! number of problems */
+	_Atomic int i;      /**<! next problem to search */
+	int i_print;        /**<! next problem to print */
+	OBFTally tally;     /**<! statistics */
+	FILE *w;            /**<! OBF file with position wrongly analyzed */
+	mtx_t mutex;        /**<! lock */
+} OBFBatch;
+
+/** A search solving problems from a batch */
+typedef struct OBFWorker {
+	Search search;      /**<! search */
+	OBFBatch *batch;    /**<! batch */
+	thrd_t thread;      /**<! thread */
+} OBFWorker;
+
+/**
+ * @brief Solve problems from a batch, until none is left.
+ *
+ * Results are printed and added to the statistics in the order of the file.
+ *
+ * @param v Worker (cast as void).
+ * @return thrd_success.
+ */
+static int obf_batch_run(void *v)
+{
+	OBFWorker *worker = (OBFWorker*) v;
+	OBFBatch *batch = worker->batch;
+	Search *search = &worker->search;
+	int i;
+
+	while ((i = atomic_fetch_add(&batch->i, 1)) < batch->n) {
+		const bool is_valid = (batch->record == NULL || obf_from_record(batch->record + i * (size_t) OBF_RECORD_SIZE, batch->obf + i));
+
+		if (is_valid) {
+			obf_setup(search, batch->obf + i);
+			search_run(search);
+		} else warn("invalid binary OBF record %d\n", i + 1);
+
+		mtx_lock(&batch->mutex);
+			if (is_valid) {
+				batch->result[i] = *search->result;
+				batch->result[i].n_nodes = search_count_nodes(search);
+				batch->is_solving[i] = search_is_solving(search);
+			}
+			batch->is_valid[i] = is_valid;
+			batch->is_done[i] = true;
+			while (batch->i_print < batch->n && batch->is_done[batch->i_print]) {
+				const int j = batch->i_print++;
+				if (!batch->is_valid[j]) continue;
+				if (options.verbosity >= 1) printf("%3d|", j + 1);
+				obf_check(batch->obf + j, batch->result + j, batch->is_solving[j], NULL);
+				batch->tally.is_solving &= batch->is_solving[j];
+				obf_tally_add(&batch->tally, batch->obf + j, batch->result + j, batch->w);
+			}
+		mtx_unlock(&batch->mutex);
+	}
+
+	return thrd_success;
+}
+
+/**
+ * @brief Test an OBF file, solving several problems simultaneously.
+ *
+ * options.n_batch searches run in parallel, each one with its share of the
+ * tasks and of the hash table memory. The results are the same as when
+ * solving the problems one after the other. The problems of a binary file
+ * are loaded from its memory map by the searches themselves.
+ *
+ * @param obf_file OBF file.
+ * @param separator Separator line.
+ * @param w OBF file with position wrongly analyzed (or NULL).
+ * @param reader Opened OBF file.
+ */
+static void obf_test_batch(const char *obf_file, const char *separator, FILE *w, OBFReader *reader)
+{
+	OBFBatch batch;
+	OBFWorker *worker;
+	const int n_batch = options.n_batch;
+	const int n_task = options.n_task;
+	int i, ok, n_max = 64;
+	int64_t t_real = -real_clock();
+	int64_t t_cpu = -cpu_clock();
+
+	// read all the problems
+	if (reader->f) {
+		batch.record = NULL;
+		batch.obf = (OBF*) malloc(n_max * sizeof (OBF));
+		batch.n = 0;
+		while (batch.obf && (ok = obf_read(batch.obf + batch.n, reader->f)) != OBF_PARSE_END) {
+			if (ok == OBF_PARSE_OK) {
+				if (++batch.n == n_max) batch.obf = (OBF*) realloc(batch.obf, (n_max *= 2) * sizeof (OBF));
+			} else obf_free(batch.obf + batch.n);
+		}
+	} else {
+		batch.record = reader->record;
+		batch.n = reader->n;
+		batch.obf = (OBF*) calloc(batch.n + 1, sizeof (OBF));
+	}
+	batch.result = (Result*) calloc(batch.n + 1, sizeof (Result));
+	batch.is_solving = (bool*) calloc(batch.n + 1, sizeof (bool));
+	batch.is_valid = (bool*) calloc(batch.n + 1, sizeof (bool));
+	batch.is_done = (bool*) calloc(batch.n + 1, sizeof (bool));
+	worker = (OBFWorker*) malloc(n_batch * sizeof (OBFWorker));
+	if (batch.obf == NULL || batch.result == NULL || batch.is_solving == NULL || batch.is_valid == NULL || batch.is_done == NULL || worker == NULL) {
+		fatal_error("obf_test: cannot allocate the problems\n");
+	}
+	atomic_init(&batch.i, 0);
+	batch.i_print = 0;
+	batch.w = w;
+	memset(&batch.tally, 0, sizeof batch.tally);
+	batch.tally.is_solving = true;
+	mtx_init(&batch.mutex, mtx_plain);
+
+	for (i = 0; i < n_batch; ++i) {
+		search_init_shared(&worker[i].search, n_batch, i);
+		worker[i].search.options.verbosity = 0;
+		worker[i].batch = &batch;
+	}
+	info("<obf_test: %d problems solved by %d searches of %d tasks>\n", batch.n, n_batch, MAX(1, n_task / n_batch));
+
+	for (i = 0; i < n_batch; ++i) thrd_create(&worker[i].thread, obf_batch_run, worker + i);
+	for (i = 0; i < n_batch; ++i) thrd_join(worker[i].thread, NULL);
+
+	t_real += real_clock();
+	if (options.verbosity == 1) printf("---+%s\n", separator);
+	batch.tally.time = t_real;
+	batch.tally.cpu_time = t_cpu + cpu_clock();
+	obf_tally_print(&batch.tally, obf_file);
+	printf("%d positions in ", batch.tally.n);
+	time_print(t_real, false, stdout);
+	if (t_real > 0) printf(" (%.0f positions/hour)", 3600000.0 * batch.tally.n / t_real);
+	putchar('\n');
+
+	for (i = 0; i < n_batch; ++i) search_free(&worker[i].search);
+	for (i = 0; i < batch.n; ++i) obf_free(batch.obf + i);
+	mtx_destroy(&batch.mutex);
+	free(worker);
+	free(batch.is_done);
+	free(batch.is_valid);
+	free(batch.is_solving);
+	free(batch.result);
+	free(batch.obf);
+}
 
 /**
  * @brief Build an OBF structure.
@@ -300,14 +721,12 @@ static void obf_build(Search *search, OBF *obf, int n)
  */
 void obf_test(Search *search, const char *obf_file, const char *wrong_file)
 {
-	FILE *f, *w = NULL;
+	OBFReader reader;
+	FILE *w = NULL;
 	OBF obf;
-	uint64_t T = 0, n_nodes = 0;
-	int n = 0, n_bad_score = 0, n_bad_move = 0;
-	double score_error = 0.0, move_error = 0.0;
-	int i, ok;
-	uint64_t cpu_time, CT = 0;
-	bool is_solving = true;
+	OBFTally tally;
+	int n = 0, ok;
+	uint64_t cpu_time;
 
 	// add observers
 //	search_cleanup(search);
@@ -316,8 +735,7 @@ void obf_test(Search *search, const char *obf_file, const char *wrong_file)
 	options.width -= 4;
 
 	// open script file with problems
-	f = fopen(obf_file, "r");
-	if (f == NULL) {
+	if (!obf_reader_open(&reader, obf_file)) {
 		fprintf(stderr, "obf_test: cannot open Othello Position Description's file %s\n", obf_file);
 		exit(EXIT_FAILURE);
 	}
@@ -334,50 +752,34 @@ void obf_test(Search *search, const char *obf_file, const char *wrong_file)
 		if (search->options.separator) printf("---+%s\n", search->options.separator);
 	}
 
-	while ((ok = obf_read(&obf, f)) != OBF_PARSE_END) {
-		if (ok == OBF_PARSE_OK) {
-			cpu_time = -cpu_clock();
-			obf_search(search, &obf, ++n);
-			is_solving &= search_is_solving(search);
-			cpu_time += cpu_clock();
-
-			T += search_time(search);
-			CT += cpu_time;
-			n_nodes += search_count_nodes(search);
-			for (i = 0; i < obf.n_moves; ++i) {
-				if (obf.move[i].x == search->result->move) break;
+	if (options.n_batch > 1) {
+		obf_test_batch(obf_file, search->options.separator ? search->options.separator : "", w, &reader);
+	} else {
+		memset(&tally, 0, sizeof tally);
+		tally.is_solving = true;
+
+		while ((ok = obf_reader_next(&reader, &obf)) != OBF_PARSE_END) {
+			if (ok == OBF_PARSE_OK) {
+				cpu_time = -cpu_clock();
+				obf_search(search, &obf, ++n);
+				tally.is_solving &= search_is_solving(search);
+				cpu_time += cpu_clock();
+
+				tally.time += search_time(search);
+				tally.cpu_time += cpu_time;
+				search->result->n_nodes = search_count_nodes(search);
+				obf_tally_add(&tally, &obf, search->result, w);
 			}
-			if (i < obf.n_moves) {
-				if (obf.move[i].score < obf.best_score) ++n_bad_move;
-				if (obf.move[i].score != search->result->score) ++n_bad_score;
-				move_error += abs(obf.best_score - obf.move[i].score);
-				if (w && obf.move[i].score < obf.best_score) obf_write(&obf, w);
-			}
-			if (obf.best_score > -SCORE_INF) score_error += abs(obf.best_score - search->result->score);
+			obf_free(&obf);
 		}
-		obf_free(&obf);
-	}
 
-	if (options.verbosity == 1 && search->options.separator) printf("---+%s\n", search->options.separator);
-	printf("%.30s: ", obf_file);
-	if (n_nodes) printf("%" PRIu64 " nodes in ", n_nodes);
-	time_print(T, false, stdout);
-	printf(" (cpu = ");
-	time_print(CT, false, stdout);
-	if (T > 0 && n_nodes > 0) printf(") (%8.0f nodes/s).", 1000.0 * n_nodes / T);
-	putchar('\n');
-
-	if ((options.verbosity >= 1 || is_solving) && (n_bad_move + n_bad_score > 0)) {
-		printf("%d positions; ", n);
-		printf("%d erroneous move; ", n_bad_move);
-		printf("%d erroneous score; ", n_bad_score);
-		printf("mean absolute score error = %.3f; ", score_error / n);
-		printf("mean absolute move error = %.3f\n", move_error / n);
+		if (options.verbosity == 1 && search->options.separator) printf("---+%s\n", search->options.separator);
+		obf_tally_print(&tally, obf_file);
 	}
 
 	options.width += 4;
 
-	fclose(f);
+	obf_reader_close(&reader);
 	if (w) fclose(w);
 }
 
@@ -444,30 +846,34 @@ void script_to_obf(Search *search, const char *script_file, const char *obf_file
 
 /**
  * @brief Select hard position from an OBF file.
+ *
+ * The filtered file has the format, text or binary, of the input file.
+ *
  * @param input_file OBF file.
  * @param output_file Filtered OBF file.
  */
 void obf_filter(const char *input_file, const char *output_file)
 {
-	FILE *in, *out;
+	OBFReader in;
+	FILE *out;
 	int i, n, f, ok;
 	int n_best, second_best;
 	OBF obf;
 
 	// open script file with problems
-	in = fopen(input_file, "r");
-	if (in == NULL) {
+	if (!obf_reader_open(&in, input_file)) {
 		fprintf(stderr, "obf_filter: cannot open Othello Position Description's file %s\n", input_file);
 		exit(EXIT_FAILURE);
 	}
-	out = fopen(output_file, "w");
+	out = fopen(output_file, in.f ? "w" : "wb");
 	if (out == NULL) {
 		fprintf(stderr, "obf_filter: cannot open Othello Position Description's file %s\n", output_file);
 		exit(EXIT_FAILURE);
 	}
+	if (in.f == NULL) obf_write_header(out);
 
 	n = f = 0;
-	while ((ok = obf_read(&obf, in)) != OBF_PARSE_END) {
+	while ((ok = obf_reader_next(&in, &obf)) != OBF_PARSE_END) {
 		if (ok == OBF_PARSE_OK) {
 			++n;
 			n_best = 0;
@@ -478,7 +884,8 @@ void obf_filter(const char *input_file, const char *output_file)
 			}
 			if (n_best == 1 && second_best == obf.best_score - 2) {
 				++f;
-				obf_write(&obf, out);
+				if (in.f) obf_write(&obf, out);
+				else obf_write_record(&obf, out);
 			}
 		}
 		obf_free(&obf);
@@ -486,7 +893,47 @@ void obf_filter(const char *input_file, const char *output_file)
 
 	printf("OBF filter: %d selected out of %d positions\n", f, n);
 
-	fclose(in);
+	obf_reader_close(&in);
+	fclose(out);
+}
+
+/**
+ * @brief Convert a text OBF file to a binary one, or a binary OBF file to a text one.
+ * @param input_file OBF file.
+ * @param output_file Converted OBF file.
+ */
+void obf_convert(const char *input_file, const char *output_file)
+{
+	OBFReader in;
+	FILE *out;
+	int n, ok;
+	OBF obf;
+
+	if (!obf_reader_open(&in, input_file)) {
+		warn("obf_convert: cannot open Othello Position Description's file %s\n", input_file);
+		return;
+	}
+	out = fopen(output_file, in.f ? "wb" : "w");
+	if (out == NULL) {
+		warn("obf_convert: cannot open Othello Position Description's file %s\n", output_file);
+		obf_reader_close(&in);
+		return;
+	}
+	if (in.f) obf_write_header(out);
+
+	n = 0;
+	while ((ok = obf_reader_next(&in, &obf)) != OBF_PARSE_END) {
+		if (ok == OBF_PARSE_OK) {
+			++n;
+			if (in.f) obf_write_record(&obf, out);
+			else obf_write(&obf, out);
+		}
+		obf_free(&obf);
+	}
+
+	printf("OBF convert: %d positions converted to %s format\n", n, in.f ? "binary" : "text");
+
+	obf_reader_close(&in);
 	fclose(out);
 }
 
@@ -17,6 +17,7 @@ struct Search;
 void obf_test(struct Search*, const char*, const char*);
 void script_to_obf(struct Search*, const char*, const char*);
 void obf_filter(const char*, const char *);
+void obf_convert(const char*, const char *);
 void obf_speed(struct Search*, const int);
 
 #endif /* EDAX_OPDTEST_H */
@@ -27,6 +27,8 @@ Options options = {
 
 	1, // n_task (will be set to system available cpus at run-time)
 	false, // cpu_affinity
+	1, // n_batch
+	false, // batch_shared_hash
 
 	1, // verbosity
 	0, // noise
@@ -102,6 +104,9 @@ void options_usage(void)
 		"  -width <n>                    line width.\n"
 		"  -h|hash-table-size <nbits>    hash table size.\n"
 		"  -n|n-tasks <n>                search in parallel using n tasks.\n"
+		"  -cpu                          bind the tasks to the cpus, grouped by numa node.\n"
+		"  -batch <n>                    solve <n> problems or book positions simultaneously.\n"
+		"  -batch-shared-hash            share a single hash table between the simultaneous searches.\n"
 #ifdef __APPLE__
 		"\nCassio protocol options:\n"
 		"  -debug-cassio                 print extra-information in cassio.\n"
@@ -149,6 +154,7 @@ int options_read(const char *option, const char *value)
 	else if (strcmp(option, "follow-cassio") == 0) options.transgress_cassio = false;
 	else if (strcmp(option, "?") == 0 || strcmp(option, "help") == 0) usage();
 	else if (strcmp(option, "cpu") == 0) options.cpu_affinity = true;
+	else if (strcmp(option, "batch-shared-hash") == 0) options.batch_shared_hash = true;
 	else {
 		read = 0;
 		if (value == NULL || *value == '\0') return read;
@@ -159,6 +165,7 @@ int options_read(const char *option, const char *value)
 
 		else if (strcmp(option, "h") == 0  || strcmp(option, "hash-table-size") == 0) options.hash_table_size = string_to_int(value, options.hash_table_size);
 		else if (strcmp(option, "n") == 0 || strcmp(option, "n-tasks") == 0) options.n_task = string_to_int(value, options.n_task);
+		else if (strcmp(option, "batch") == 0) options.n_batch = string_to_int(value, options.n_batch);
 		else if (strcmp(option, "l") == 0 || strcmp(option, "level") == 0) {
 			options.level = string_to_int(value, options.level);
 			options.play_type = EDAX_FIXED_LEVEL;
@@ -298,6 +305,7 @@ void options_bound(void)
 
 	max_threads = MIN(get_cpu_number(), MAX_THREADS);
 	BOUND(options.n_task, 1, max_threads, "n-tasks");
+	BOUND(options.n_batch, 1, options.n_task, "batch");
 
 	BOUND(options.verbosity, 0, 4, "verbosity");
 	BOUND(options.noise, 0, 60, "noise");
@@ -347,6 +355,9 @@ void options_dump(FILE *f)
 	fprintf(f, "\tsize (in number of bits) of the hash table: %d\n", options.hash_table_size);
 	fprintf(f, "\tsorting depth increment: pv = %d, all = %d, cut = %d\n",  options.inc_sort_depth[0], options.inc_sort_depth[1], options.inc_sort_depth[2]);
 	fprintf(f, "\ttask number for parallel search: %d\n", options.n_task);
+	fprintf(f, "\ttask bound to cpu: %s\n", bool_string[options.cpu_affinity]);
+	fprintf(f, "\tproblems or book positions searched simultaneously: %d\n", options.n_batch);
+	fprintf(f, "\tsimultaneous searches share a hash table: %s\n", bool_string[options.batch_shared_hash]);
 	fprintf(f, "\tsearch level: %d\n", options.level);
 	fprintf(f, "\tsearch alloted time:"); time_print(options.time, false, stdout); fprintf(f, "\n");
 	fprintf(f, "\tsearch with: %s\n", play_type[options.play_type]);
@@ -29,6 +29,8 @@ typedef struct {
 
 	int n_task;                           /**< search in parallel, using n_tasks */
 	bool cpu_affinity;                    /**< set one cpu/thread to diminish context change */
+	int n_batch;                          /**< number of problems solved simultaneously */
+	bool batch_shared_hash;               /**< problems solved simultaneously share a hash table */
 
 	int verbosity;                        /**< search display */
  	int noise;                            /**< search display min depth */
@@ -207,6 +207,32 @@ bool play_must_pass(Play *play)
 		can_move(play->board.opponent, play->board.player);
 }
 
+/**
+ * @brief Get the opening book to read.
+ *
+ * Once a snapshot of the book has been published, the book is read from a
+ * view of its last snapshot, so that it can be modified or saved meanwhile.
+ *
+ * @param play Play.
+ * @param view Storage for a view of the book.
+ * @return the book to read, to give back with play_book_release.
+ */
+static Book* play_book_acquire(Play *play, Book *view)
+{
+	return book_acquire(play->book, view) ? view : play->book;
+}
+
+/**
+ * @brief Give back a book got with play_book_acquire.
+ *
+ * @param book Book to give back.
+ * @param view Storage for a view of the book.
+ */
+static void play_book_release(Book *book, Book *view)
+{
+	if (book == view) book_release(view);
+}
+
 /**
  * @brief Start thinking.
  * @param play Play.
@@ -220,12 +246,14 @@ void play_go(Play *play, const bool update)
 	int64_t t_cpu = -cpu_clock();
 	Move move;
 	Search *search = &play->search;
+	Book view, *book;
 	char s_move[4];
 
 	info("\n[entering play_go]\n");
 
 	if (play_is_game_over(play)) return;
 
+	book = play_book_acquire(play, &view);
 	if (play_force_go(play, &move)) {
 		play_stop_pondering(play);
 
@@ -243,7 +271,7 @@ void play_go(Play *play, const bool update)
 			info("\n[Forced move %s]\n\n",  move_to_string(move.x, play->player, s_move));
 		}
 
-	} else if (options.book_allowed && book_get_random_move(play->book, &play->board, &move, options.book_randomness)) {
+	} else if (options.book_allowed && book_get_random_move(book, &play->board, &move, options.book_randomness)) {
 		play_stop_pondering(play);
 
 		play->result.depth = 0;
@@ -254,11 +282,11 @@ void play_go(Play *play, const bool update)
 		play->result.time = real_clock() + t_real;
 		play->result.n_nodes = 0;
 		line_init(&play->result.pv, play->player);
-		book_get_line(play->book, &play->board, &move, &play->result.pv);
+		book_get_line(book, &play->board, &move, &play->result.pv);
 
 		if (options.verbosity) {
 			info("\n[book move]\n");
-			if (options.info) book_show(play->book, &play->board);
+			if (options.info) book_show(book, &play->board);
 			info("\n\n");
 
 			if (play->type == UI_XBOARD) {
@@ -300,6 +328,10 @@ void play_go(Play *play, const bool update)
 
 		play->result = *search->result;
 		play->state = IS_WAITING;
+		if (log_is_open(&xboard_log)) {
+			fprintf(xboard_log.f, "edax search> ponder hit: level %d@%d%% reached in %.2f s\n",
+				play->result.depth, selectivity_table[play->result.selectivity].percent, 0.001 * (real_clock() + t_real));
+		}
 		if (!board_get_move(&play->board, search->result->move, &move) && move.x != PASS) {
 			fatal_error("bad move found: %s\n", move_to_string(move.x, play->player, s_move));
 		}
@@ -309,6 +341,7 @@ void play_go(Play *play, const bool update)
 		}
 
 	} else {
+		const bool is_ponder_miss = (play->state == IS_PONDERING);
 
 		play_stop_pondering(play);
 
@@ -337,6 +370,10 @@ void play_go(Play *play, const bool update)
 		search_run(search);
 		play->result = *search->result;
 		play->state = IS_WAITING;
+		if (is_ponder_miss && log_is_open(&xboard_log)) {
+			fprintf(xboard_log.f, "edax search> ponder miss: level %d@%d%% reached in %.2f s\n",
+				play->result.depth, selectivity_table[play->result.selectivity].percent, 0.001 * (real_clock() + t_real));
+		}
 		if (!board_get_move(&play->board, search->result->move, &move) && move.x != PASS) {
 			fatal_error("bad move found: %s\n", move_to_string(move.x, play->player, s_move));
 		}
@@ -346,6 +383,8 @@ void play_go(Play *play, const bool update)
 		}
 	}
 
+	play_book_release(book, &view);
+
 	t_real += real_clock() + 1;
 	t_cpu += cpu_clock() + 1;
 	info("[cpu usage: %.2f%%]\n", 100.0 * t_cpu / t_real);
@@ -356,10 +395,52 @@ void play_go(Play *play, const bool update)
 
 }
 
+/**
+ * @brief Print the score of a root move, as soon as it is known.
+ *
+ * @param result Search result, with the bounds of the move score.
+ * @param x Move.
+ * @param depth Searched depth.
+ * @param selectivity Searched selectivity.
+ */
+static void play_hint_observer(Result *result, const int x, const int depth, const int selectivity)
+{
+	const Bound *bound = result->bound + x;
+	char s[4];
+
+	if (bound->lower == bound->upper) {
+		printf("move    %s %+03d @ %d@%d%%\n", move_to_string(x, BLACK, s), bound->lower, depth, selectivity_table[selectivity].percent);
+		fflush(stdout);
+	}
+}
+
+/**
+ * @brief Print the score of a root move, as soon as it is known, for NBoard.
+ *
+ * @param result Search result, with the bounds of the move score.
+ * @param x Move.
+ * @param depth Searched depth.
+ * @param selectivity Searched selectivity.
+ */
+static void play_hint_nboard_observer(Result *result, const int x, const int depth, const int selectivity)
+{
+	const Bound *bound = result->bound + x;
+	char s[4];
+
+	(void) selectivity; // NBoard only wants the depth
+
+	if (bound->lower == bound->upper) {
+		printf("search %s %d 0 %d\n", move_to_string(x, BLACK, s), bound->lower, depth);
+		fflush(stdout);
+	}
+}
+
 /**
  * @brief Start thinking.
  *
- * Evaluate first best moves of the position.
+ * Evaluate first best moves of the position. When several moves are
+ * evaluated, the score of each root move is printed as soon as the first
+ * search knows it.
  *
  * @param play Play.
  * @param n Number of (best) moves to evaluate.
@@ -371,6 +452,7 @@ void play_hint(Play *play, int n)
 	Search *search = &play->search;
 	MoveList book_moves;
 	GameStats stat;
+	Book view, *book;
 	Board b;
 
 	if (play_is_game_over(play)) return;
@@ -390,29 +472,33 @@ void play_hint(Play *play, int n)
 	if (n > search->movelist.n_moves) n = search->movelist.n_moves;
 	info("<hint %d moves>\n", n);
 
-	if (options.book_allowed && book_get_moves(play->book, &play->board, &book_moves)) {
+	book = play_book_acquire(play, &view);
+	if (options.book_allowed && book_get_moves(book, &play->board, &book_moves)) {
 		foreach_move (m, &book_moves) if (n) {
 			--n;
 			line_init(&pv, play->player);
-			book_get_line(play->book, &play->board, m, &pv);
+			book_get_line(book, &play->board, m, &pv);
 			movelist_exclude(&search->movelist, m->x);
 			if (play->type == UI_NBOARD) {
 				board_next(&play->board, m->x, &b);
-				book_get_game_stats(play->book, &b, &stat);
+				book_get_game_stats(book, &b, &stat);
 				printf("book "); line_print(&pv, 10, NULL, stdout);
-				printf(" %d %" PRIu64 " %d\n", m->score, stat.n_lines, play->book->options.level);
+				printf(" %d %" PRIu64 " %d\n", m->score, stat.n_lines, book->options.level);
 			} else {
 				printf("book    %+02d                                          ", m->score);
 				line_print(&pv, options.width - 54, " ", stdout); putchar('\n');
 			}
 		}
 	}
+	play_book_release(book, &view);
 
+	if (n > 1) search_set_move_observer(search, play->type == UI_NBOARD ? play_hint_nboard_observer : play_hint_observer);
 	while (n--) {
 		if (options.play_type == EDAX_TIME_PER_MOVE) search_set_move_time(search, options.time);
 		else search_set_game_time(search, play->time[play->player].left);
 		if (n) search->options.multipv_depth = 60;
 		search_run(search);
+		search_set_move_observer(search, NULL);
 		search->options.multipv_depth = MULTIPV_DEPTH;
 		if (play->type == UI_NBOARD) {
 			printf("search "); line_print(&search->result->pv, 10, NULL, stdout);
@@ -447,7 +533,7 @@ int play_ponder_run(void *v)
 	Play *play = (Play*) v;
 	int player;
 	Search *search = &play->search;
-	Board board;
+	Board board, parent;
 	Move move;
 	char m[4];
 
@@ -466,9 +552,11 @@ int play_ponder_run(void *v)
 		if (play->state == IS_PONDERING && move.x != NOMOVE) {
 			board_get_move(&board, move.x, &move);
 
+			parent = board;
 			board_update(&board, &move);
 				play->ponder.board = board;
 				search_set_board(search, &board, player ^ 1);
+				search_set_guess(search, &parent, move.x);
 				search_set_level(search, options.level, search->n_empties);
 				search_run(search);
 				if (options.info && play->state == IS_PONDERING) {
@@ -538,7 +626,7 @@ void play_stop_pondering(Play *play)
 	while (play->state == IS_PONDERING) {
 		info("[stop pondering]\n");
 		search_stop_all(&play->search, STOP_PONDERING);
-		relax(10);
+		relax(1);
 	}
 
 	if (play->ponder.launched) {
@@ -546,7 +634,7 @@ void play_stop_pondering(Play *play)
 		if (play->search.stop == RUNNING) {
 			info("[stop running search?]");
 			search_stop_all(&play->search, STOP_PONDERING);
-			relax(10);
+			relax(1);
 		}
 		thrd_join(play->ponder.thread, NULL);
 		play->ponder.launched = false;
@@ -879,8 +967,11 @@ static int play_book_alternative(Play *play, Move *played, Move* alternative)
 	Move *exclude, *best;
 	Board excluded, board, unique;
 	Move *move;
+	Book view, *book = play_book_acquire(play, &view);
+	bool found = book_get_moves(book, &play->board, &movelist);
 
-	if (book_get_moves(play->book, &play->board, &movelist)) {
+	play_book_release(book, &view);
+	if (found) {
 		exclude = movelist_exclude(&movelist, played->x);
 
 		if (exclude && exclude->x == played->x) {
@@ -236,6 +236,33 @@ void record_best_move(Search *search, const Board *init_board, const Move *bestm
 	if (has_changed && options.noise <= depth && search->options.verbosity == 3) search->observer(search->result);
 }
 
+/**
+ * @brief Record the score of a root move in multi PV mode.
+ *
+ * Every root move is searched with its own window, so its score is final as
+ * soon as its search returns: its bounds are stored into the result and, if
+ * they changed, the move observer is called. The caller serializes the calls.
+ *
+ * @param search Search.
+ * @param move Searched move.
+ * @param alpha Alpha Bound.
+ * @param beta Beta Bound.
+ */
+void record_move_score(Search *search, const Move *move, const int alpha, const int beta)
+{
+	Result *result = search->result;
+	Bound *bound = result->bound + move->x;
+	Bound old;
+
+	spinlock_lock(&result->spin);
+		old = *bound;
+		bound->lower = (move->score > alpha ? move->score : search->stability_bound.lower);
+		bound->upper = (move->score < beta ? move->score : search->stability_bound.upper);
+	spinlock_unlock(&result->spin);
+
+	if (search->move_observer && (bound->lower != old.lower || bound->upper != old.upper)) search->move_observer(result, move->x, search->depth, search->selectivity);
+}
+
 void show_current_move(FILE *f, Search *search, const Move *move, const int alpha, const int beta, const bool parallel) {
 	char s[4];
 
@@ -354,12 +381,14 @@ int PVS_root(Search *search, const int alpha, const int beta, const int depth)
 
 	node_init(&node, search, alpha, beta, depth, movelist->n_moves, NULL);
 	node.pv_node = true;
+	node.multipv = (depth <= search->options.multipv_depth);
 	search->node_type[0] = PV_NODE;
 	search->time.can_update = false;
 
 	// special cases: pass or game over
 	if (movelist_is_empty(movelist)) {
 		move = movelist->move->next = movelist->move + 1;
+		move->next = NULL;
 		move->flipped = 0;
 		if (can_move(board->opponent, board->player)) {
 			search_update_pass_midgame(search);
@@ -394,10 +423,10 @@ int PVS_root(Search *search, const int alpha, const int beta, const int depth)
 		}
 		// other moves : try to refute the first/best one
 		while ((move = node_next_move(&node))) {
-			const int alpha = depth > search->options.multipv_depth ? node.alpha : SCORE_MIN;
+			const int alpha = node.multipv ? SCORE_MIN : node.alpha;
 
 			assert(board_check_move(board, move));
-			if (depth > search->options.multipv_depth && node_split(&node, move)) {
+			if (node_split(&node, move)) {
 			} else {
 				search_update_midgame(search, move);
 					move->score = -search_route_PVS(search, -alpha - 1, -alpha, depth - 1, &node);
@@ -627,6 +656,96 @@ static bool get_last_level(Search *search, int *depth, int *selectivity)
 	return *depth > -1 && *selectivity > -1;
 }
 
+/**
+ * @brief Remember the last completed iteration of the root search.
+ *
+ * @param search Search.
+ * @param score Score of the iteration.
+ */
+static void search_remember(Search *search, const int score)
+{
+	Move *move;
+	int n = 0;
+
+	search->previous.board = search->board;
+	search->previous.depth = search->depth;
+	search->previous.selectivity = search->selectivity;
+	search->previous.score = score;
+	foreach_move(move, &search->movelist) {
+		search->previous.move[n] = move->x;
+		search->previous.move_score[n] = move->score;
+		++n;
+	}
+	search->previous.n_moves = n;
+	search->previous.n_exact = (search->depth <= search->options.multipv_depth ? n : MIN(n, 1));
+	search->previous.parent = search->guess.parent;
+	search->previous.guess = search->guess.move;
+}
+
+/**
+ * @brief Retrieve the level of the previous root search.
+ *
+ * The previous search is reused if it was done on the same position, or on its
+ * parent position through a move with an exact score, as it happens after the
+ * opponent's move when pondering. The completed depth & selectivity and the
+ * score of the previous search (or of the move leading to the current position)
+ * are carried over, even if the hash entries were overwritten since.
+ *
+ * After a ponder miss, the previous search was done on a sibling of the current
+ * position, reached by the guessed move instead of the one actually played. Its
+ * depth & selectivity, its score and its root move ordering are carried over.
+ *
+ * @param search Search.
+ * @param depth Depth of the previous search.
+ * @param selectivity Selectivity of the previous search.
+ * @param score Score of the previous search.
+ * @param is_ordered Set to true if the previous root move ordering applies.
+ * @return true if the previous search can be reused.
+ */
+static bool get_previous_level(Search *search, int *depth, int *selectivity, int *score, bool *is_ordered)
+{
+	Board child;
+	uint64_t moves;
+	int i, x;
+
+	if (search->previous.depth <= 0) return false;
+
+	if (board_equal(&search->board, &search->previous.board)) {
+		*depth = search->previous.depth;
+		*selectivity = search->previous.selectivity;
+		*score = search->previous.score;
+		*is_ordered = true;
+		return true;
+	}
+
+	if (search->previous.guess != NOMOVE) {
+		moves = get_moves(search->previous.parent.player, search->previous.parent.opponent);
+		foreach_bit(x, moves) {
+			board_next(&search->previous.parent, x, &child);
+			if (x != search->previous.guess && board_equal(&search->board, &child)) {
+				*depth = search->previous.depth;
+				*selectivity = search->previous.selectivity;
+				*score = search->previous.score;
+				*is_ordered = true;
+				return true;
+			}
+		}
+	}
+
+	for (i = 0; i < search->previous.n_exact; ++i) {
+		board_next(&search->previous.board, search->previous.move[i], &child);
+		if (board_equal(&search->board, &child)) {
+			if (search->previous.depth <= 1) return false;
+			*depth = search->previous.depth - 1;
+			*selectivity = search->previous.selectivity;
+			*score = -search->previous.move_score[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * @brief Iterative deepening.
  *
@@ -647,8 +766,9 @@ void iterative_deepening(Search *search, int alpha, int beta)
 	HashData hash_data;
 	int score, end, start;
 	int64_t t;
-	bool has_time;
+	bool has_time, is_reused = false, is_ordered = false;
 	int old_depth, old_selectivity, tmp_selectivity;
+	int i;
 
 	assert(alpha < beta);
 	assert(SCORE_MIN <= alpha && alpha <= SCORE_MAX);
@@ -720,6 +840,7 @@ void iterative_deepening(Search *search, int alpha, int beta)
 				if (get_last_level(search, &old_depth, &old_selectivity)) {
 					start = old_depth;
 					search->selectivity = old_selectivity;
+					is_reused = true;
 				}
 				score = hash_data.lower;
 			} else {
@@ -733,6 +854,20 @@ void iterative_deepening(Search *search, int alpha, int beta)
 		log_print(&search_log, "--- New Search ---:\n");
 	}
 
+	// restart from the previous root search (after a ponder miss, ...)
+	if (USE_PREVIOUS_SEARCH && !is_reused && get_previous_level(search, &old_depth, &old_selectivity, &score, &is_ordered)) {
+		start = old_depth;
+		search->selectivity = old_selectivity;
+		score = search_bound(search, score);
+		is_reused = true;
+		if (log_is_open(&search_log)) { // search_log.mutex is already locked here
+			log_print(&search_log, "--- Restart from previous search at level %d@%d%% ---:\n", old_depth, selectivity_table[old_selectivity].percent);
+		}
+		if (search->options.verbosity >= 2) {
+			info("<restart from previous search at level %d@%d%%>\n", old_depth, selectivity_table[old_selectivity].percent);
+		}
+	}
+
 	if (search->selectivity > search->options.selectivity) search->selectivity = search->options.selectivity;
 
 	if (start > search->options.depth) start = search->options.depth;
@@ -761,6 +896,9 @@ void iterative_deepening(Search *search, int alpha, int beta)
 			movelist_evaluate(movelist, search, &hash_data, alpha, start);
 		}
 		movelist_sort(movelist);
+		if (is_reused && (is_ordered || board_equal(board, &search->previous.board))) { // restore the previous move ordering
+			for (i = search->previous.n_moves - 1; i >= 0; --i) movelist_sort_bestmove(movelist, search->previous.move[i]);
+		}
 		bestmove = movelist_first(movelist); bestmove->score = score;
 		record_best_move(search, board, bestmove, alpha, beta, old_depth);
 		assert(SCORE_MIN <= result->score  && result->score <= SCORE_MAX);
@@ -793,6 +931,7 @@ void iterative_deepening(Search *search, int alpha, int beta)
 		}
 		search->depth_pv_extension = get_pv_extension(search->depth, search->n_empties);
 		score = aspiration_search(search, alpha, beta, search->depth, score);
+		if (!search->stop) search_remember(search, score);
 		if (!search_continue(search)) return;
 		if (abs(score) >= SCORE_MAX - 1 && search->depth > end - ITERATIVE_MIN_EMPTIES && search->options.depth >= search->n_empties) break;
 	}
@@ -816,6 +955,7 @@ void iterative_deepening(Search *search, int alpha, int beta)
 		}
 		if (search->selectivity == search->options.selectivity) search_adjust_time(search, true);
 		score = aspiration_search(search, alpha, beta, search->depth, score);
+		if (!search->stop) search_remember(search, score);
 		if (!search_continue(search)) return;
 	}
 	if (search->selectivity > search->options.selectivity) search->selectivity = search->options.selectivity;
@@ -838,14 +978,21 @@ int search_run(void *v)
 {
 	Search *search = (Search*) v;
 	Move *move;
+	CpuSet cpus;
+	bool is_bound = false;
 
 	search->stop = RUNNING;
 
+	// keep the main search thread on its numa node, while the search lasts
+	if (search->task->cpu >= 0 && thread_get_cpus(&cpus)) is_bound = thread_set_cpu(search->task->cpu);
+
 	//initialisations
 	search->n_nodes = 0;
 	search->child_nodes = 0;
 	search->time.spent = -search_clock(search);
 	search_time_init(search);
+	search->time.next_check = 0;
+	search->time.stop_request = 0;
 	if (!search->options.keep_date) {
 		hash_clear(&search->hash_table);
 		hash_clear(&search->pv_table);
@@ -899,12 +1046,15 @@ int search_run(void *v)
 	if (search->stop == RUNNING) search->stop = STOP_END;
 	search->time.spent += search_clock(search);
 	search->result->time = search->time.spent;
+	YBWC_STATS(if (search->time.stop_request) statistics_add_stop_latency(nano_clock() - search->time.stop_request);)
 
 	statistics_sum_nodes(search);
 	if (search->options.verbosity >= 3) statistics_print(stdout);
 
 	assert(search->height == 0);
 
+	if (is_bound) thread_set_cpus(&cpus);
+
 	return thrd_success;
 }
 
@@ -355,12 +355,12 @@ void search_resize_hashtable(Search *search) {
 }
 
 /**
- * @brief Init the *main* search.
+ * @brief Init a search, binding its tasks from a given cpu.
  *
- * Initialize a new search structure.
  * @param search  search.
+ * @param first_cpu Index of the cpu of its first task.
  */
-void search_init(Search *search)
+static void search_create(Search *search, const int first_cpu)
 {
 	/* id */
 	search->id = 0;
@@ -381,6 +381,8 @@ void search_init(Search *search)
 	/* board */
 	search->board.player = search->board.opponent = 0;
 	search->player = EMPTY;
+	search->previous.depth = -1;
+	search->previous.guess = search->guess.move = NOMOVE;
 
 	/* evaluation function */
 	eval_init(&search->eval);
@@ -393,7 +395,7 @@ void search_init(Search *search)
 	if (search->tasks == NULL) {
 		fatal_error("Cannot allocate a task stack\n");
 	}
-	task_stack_init(search->tasks, options.n_task);
+	task_stack_init(search->tasks, options.n_task, first_cpu);
 	search->allow_node_splitting = (search->tasks->n > 1);
 
 	/* task associated with the current search */
@@ -427,6 +429,7 @@ void search_init(Search *search)
 
 	/* observers */
 	search->observer = search_observer;
+	search->move_observer = NULL;
 
 	/* options */
 	search->options.depth = 60;
@@ -443,6 +446,42 @@ void search_init(Search *search)
 	log_open(&search_log, options.search_log_file);
 }
 
+/**
+ * @brief Init the *main* search.
+ *
+ * Initialize a new search structure.
+ * @param search  search.
+ */
+void search_init(Search *search)
+{
+	search_create(search, 0);
+}
+
+/**
+ * @brief Init a search sharing the tasks & the hash table memory with others.
+ *
+ * Each of the n searches gets n_task / n tasks and 1 / 2^ceil(log2(n)) of the
+ * hash table memory. The tasks of the search with the given id are bound to
+ * the cpus following those of the previous searches.
+ *
+ * @param search search.
+ * @param n Number of searches running simultaneously.
+ * @param id Search id, from 0 to n - 1.
+ */
+void search_init_shared(Search *search, const int n, const int id)
+{
+	const int n_task = options.n_task, hash_table_size = options.hash_table_size;
+	int shift = 0;
+
+	while ((1 << shift) < n) ++shift;
+	options.n_task = MAX(1, n_task / n);
+	options.hash_table_size = MAX(10, hash_table_size - shift);
+	search_create(search, id * options.n_task);
+	search->id = id;
+	options.n_task = n_task;
+	options.hash_table_size = hash_table_size;
+}
+
 /**
  * @brief Free the search allocated ressource.
  *
@@ -516,27 +555,38 @@ void search_setup(Search *search)
 /**
  * @brief Clone a search for parallel search.
  *
+ * The master is stopped at the split point, with its empty square list, parity
+ * and evaluation features in sync with its board. So they are copied rather than
+ * recomputed by search_setup(), which makes splitting a node much cheaper.
+ *
  * @param search search.
  * @param master search to be cloned.
  */
 void search_clone(Search *search, Search *master)
 {
+	YBWC_STATS(const int64_t t = nano_clock();)
+
 	search->id = -1;
 	search->stop = STOP_END;
 	search->player = master->player;
 	search->board = master->board;
-	search_setup(search);
+	search->n_empties = master->n_empties;
+	search->parity = master->parity;
+	memcpy(search->empties, master->empties, sizeof search->empties);
+	eval_copy(&search->eval, &master->eval);
 	search->hash_table = master->hash_table; // share the hashtable
 	search->pv_table = master->pv_table; // share the pvtable
 	search->shallow_table = master->shallow_table; // share the shallowtable
 	search->tasks = master->tasks;
 	search->observer = master->observer;
+	search->move_observer = master->move_observer;
 
 	search->depth = master->depth;
 	search->selectivity = master->selectivity;
 	search->probcut_level = master->probcut_level;
 	search->depth_pv_extension = master->depth_pv_extension;
 	search->time = master->time;
+	search->time.next_check = 0;
 	search->height = master->height;
 	search->allow_node_splitting = master->allow_node_splitting;
 	search->node_type[search->height] = master->node_type[search->height];
@@ -551,6 +601,9 @@ void search_clone(Search *search, Search *master)
 	spinlock_unlock(&master->spin);
 	search->parent = master;
 	search->master = master->master;
+
+	YBWC_STATS(atomic_fetch_add(&statistics.n_clone, 1);)
+	YBWC_STATS(atomic_fetch_add(&statistics.clone_time, nano_clock() - t);)
 }
 
 /**
@@ -563,6 +616,7 @@ void search_cleanup(Search *search)
 	hash_cleanup(&search->hash_table);
 	hash_cleanup(&search->pv_table);
 	hash_cleanup(&search->shallow_table);
+	search->previous.depth = -1;
 }
 
 
@@ -577,10 +631,27 @@ void search_set_board(Search *search, const Board *board, const int player)
 {
 	search->player = player;
 	search->board = *board;
+	search->guess.move = NOMOVE;
 	search_setup(search);
 	search_get_movelist(search, &search->movelist);
 }
 
+/**
+ * @brief Set the opponent's move guessed to reach the root, when pondering.
+ *
+ * On a ponder miss, the search of the actual position can restart from the
+ * search of the guessed one, its sibling.
+ *
+ * @param search Search, whose root is set.
+ * @param parent Position before the guessed move.
+ * @param move Guessed move.
+ */
+void search_set_guess(Search *search, const Board *parent, const int move)
+{
+	search->guess.parent = *parent;
+	search->guess.move = move;
+}
+
 /**
  * @brief Set the search level.
  *
@@ -785,6 +856,10 @@ void search_check_timeout(Search *search)
 	int64_t t;
 	Search *master = search->master;
 
+	// reading the clock is not free: check every TIMEOUT_CHECK_NODES nodes only
+	if (search->n_nodes < search->time.next_check) return;
+	search->time.next_check = search->n_nodes + TIMEOUT_CHECK_NODES;
+
 	assert(master->master == master);
 
 	if (master->stop != STOP_TIMEOUT) {
@@ -1086,6 +1161,21 @@ void search_set_observer(Search *search, void (*observer)(Result*))
 	search->observer = observer;
 }
 
+/**
+ * @brief set the root move observer.
+ *
+ * In multi PV mode, the observer is called each time the score of a root move
+ * is final, with the move, the searched depth and selectivity as arguments.
+ * Its bounds are stored in the result.
+ *
+ * @param search Searched position.
+ * @param observer call back function to print a root move score, or NULL.
+ */
+void search_set_move_observer(Search *search, void (*observer)(Result*, const int, const int, const int))
+{
+	search->move_observer = observer;
+}
+
 /**
  * @brief Print the current search result.
  *
@@ -1321,6 +1411,7 @@ void search_stop_all(Search *search, const Stop stop)
 	int i;
 
 	spinlock_lock(&search->spin);
+		YBWC_STATS(if (search->master == search && search->stop == RUNNING) search->time.stop_request = nano_clock();)
 		search->stop = stop;
 		for (i = 0; i < search->n_child; ++i) {
 			search_stop_all(search->child[i], stop);
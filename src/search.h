@@ -90,8 +90,26 @@ typedef struct Search {
 		bool can_update;                          /**< flag allowing to extend time */
 		int64_t mini;                             /**< minimal alloted time */
 		int64_t maxi;                             /**< maximal alloted time */
+		int64_t next_check;                       /**< node count at the next time-out check */
+		int64_t stop_request;                     /**< time of the stop request, in ns (statistics) */
 	} time;                                       /**< time */
 	MoveList movelist;                            /**< list of moves */
+	struct {
+		Board board;                              /**< root position */
+		int depth;                                /**< last completed depth (-1 if none) */
+		int selectivity;                          /**< last completed selectivity */
+		int score;                                /**< last score */
+		int n_moves;                              /**< number of root moves */
+		int n_exact;                              /**< number of root moves with an exact score */
+		int move[MAX_MOVE];                       /**< root moves, best first */
+		int move_score[MAX_MOVE];                 /**< root move scores */
+		Board parent;                             /**< position before the guessed move (pondering) */
+		int guess;                                /**< guessed move leading to the root (NOMOVE if none) */
+	} previous;                                   /**< previous root search, to restart the next search from */
+	struct {
+		Board parent;                             /**< position before the guessed move */
+		int move;                                 /**< guessed move leading to the root (NOMOVE if none) */
+	} guess;                                      /**< opponent's move guessed to ponder on the root */
 	NodeType node_type[GAME_SIZE];                /**< node type (pv node, cut node, all node) */
 	Bound stability_bound;                        /**< score bounds according to stable squares */
 	Stop stop;                                    /**< thinking status */
@@ -120,6 +138,7 @@ typedef struct Search {
 	Result *result;                               /**< shared result */ //TODO: remove allocation ?
 
 	void (*observer)(Result*);                    /**< call back function to print search result */
+	void (*move_observer)(Result*, const int, const int, const int); /**< call back function to print a root move score (multi PV) */
 
 	int64_t n_nodes;                              /**< node counter */
 	int64_t child_nodes;                          /**< node counter */
@@ -138,11 +157,13 @@ extern const uint8_t SQUARE_TYPE[];
 /* function definition */
 void search_global_init(void);
 void search_init(Search*);
+void search_init_shared(Search*, const int, const int);
 void search_free(Search*);
 void search_cleanup(Search*);
 void search_setup(Search*);
 void search_clone(Search*, Search*);
 void search_set_board(Search*, const Board*, const int);
+void search_set_guess(Search*, const Board*, const int);
 void search_set_level(Search*, const int, const int);
 void search_set_ponder_level(Search*, const int, const int);
 void search_resize_hashtable(Search*);
@@ -200,6 +221,7 @@ int PVS_shallow(Search*, int, int, int);
 
 bool is_pv_ok(Search*, int, int);
 void record_best_move(Search*, const Board*, const Move*, const int, const int, const int);
+void record_move_score(Search*, const Move*, const int, const int);
 int PVS_root(Search*, const int, const int, const int);
 int aspiration_search(Search*, int, int, const int, int);
 void iterative_deepening(Search*, int, int);
@@ -210,6 +232,7 @@ void search_set_state(Search*, const Stop);
 
 void search_observer(Result*);
 void search_set_observer(Search*, void (*Observer)(Result*));
+void search_set_move_observer(Search*, void (*Observer)(Result*, const int, const int, const int));
 
 void search_share(const Search*, Search*);
 int search_count_tasks(const Search *);
@@ -183,6 +183,9 @@
 /** Stop Node splitting (for parallel search) after a few splitting.  */
 #define SPLIT_MAX_SLAVES 3
 
+/** Check the time-out every this number of nodes. */
+#define TIMEOUT_CHECK_NODES 256
+
 /** Branching factor (to adjust alloted time). */
 #define BRANCHING_FACTOR 2.0
 
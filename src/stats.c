@@ -18,11 +18,39 @@
 #include "ybwc.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <inttypes.h>
 
 Statistics statistics;
 
+/**
+ * @brief Compare two latencies (for qsort).
+ *
+ * @param a First latency.
+ * @param b Second latency.
+ * @return -1, 0 or 1.
+ */
+static int latency_compare(const void *a, const void *b)
+{
+	const int64_t x = *(const int64_t*) a, y = *(const int64_t*) b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Record the time from a stop request to the end of the search.
+ *
+ * Several searches may stop at the same time (-batch), so each one reserves
+ * its own slot of the ring buffer.
+ *
+ * @param latency Latency in ns.
+ */
+void statistics_add_stop_latency(const int64_t latency)
+{
+	statistics.stop_latency[atomic_fetch_add(&statistics.n_stop, 1) % STATS_STOP_SAMPLES] = latency;
+}
+
 /**
  * @brief Intialization of the statistics.
  */
@@ -42,16 +70,23 @@ void statistics_init(void)
 	for (i = 0; i < MAX_THREADS; ++i) {
 		statistics.n_task_nodes[i] = 0;
 		statistics.n_task[i] = 0;
+		statistics.task_numa_node[i] = 0;
 	}
 	statistics.n_parallel_nodes = 0;
 	statistics.n_nodes = 0;
 	statistics.n_split_try = 0;
 	statistics.n_split_success = 0;
+	statistics.n_split_local = 0;
 	statistics.n_master_helper = 0;
 	statistics.n_stopped_slave = 0;
 	statistics.n_stopped_master = 0;
 	statistics.n_waited_slave = 0;
 	statistics.n_wake_up = 0;
+	statistics.n_clone = 0;
+	statistics.clone_time = 0;
+	statistics.n_node_lock = 0;
+	statistics.node_lock_time = 0;
+	statistics.n_stop = 0;
 
 	statistics.n_PVS_root = 0;
 	statistics.n_PVS_midgame = 0;
@@ -107,6 +142,7 @@ void statistics_sum_nodes(Search *search)
 	for (i = 0; i < search->tasks->n; ++i) {
 		statistics.n_task_nodes[i] = search->tasks->task[i].n_nodes;
 		statistics.n_task[i] = search->tasks->task[i].n_calls;
+		statistics.task_numa_node[i] = search->tasks->task[i].numa_node;
 	}
 }
 
@@ -127,15 +163,39 @@ void statistics_print(FILE *f)
 		fprintf(f, "slave nodes stopped: %12" PRIu64 " (%6.2f%%)\n", statistics.n_stopped_slave, 100.0 * statistics.n_stopped_slave / statistics.n_split_success);
 		fprintf(f, "slave master stopped:%12" PRIu64 " (%6.2f%%) = %12" PRIu64 "\n", statistics.n_stopped_master, 100.0 * statistics.n_stopped_master / statistics.n_split_success, statistics.n_wake_up);
 		fprintf(f, "slave nodes waited:  %12" PRIu64 " (%6.2f%%)\n", statistics.n_waited_slave, 100.0 * statistics.n_waited_slave / statistics.n_split_success);
+		if (statistics.n_node_lock) fprintf(f, "node lock hold:      %12.0f ns (%" PRIu64 " locks, %.3f s)\n", (double) statistics.node_lock_time / statistics.n_node_lock, statistics.n_node_lock, 1e-9 * statistics.node_lock_time);
+		if (statistics.n_clone) fprintf(f, "split cost:          %12.0f ns (%" PRIu64 " clones)\n", (double) statistics.clone_time / statistics.n_clone, statistics.n_clone);
 		fprintf(f, "main thread (%" PRIu64 " nodes)\n", statistics.n_nodes);
 		for (i = 1; i < options.n_task; ++i) {
 			fprintf(f, "task %d called %" PRIu64 " times (%" PRIu64 " nodes)\n", i, statistics.n_task[i], statistics.n_task_nodes[i]);
 			n_helper_nodes -= statistics.n_task_nodes[i];
 		}
 		fprintf(f, "helper (%" PRIu64 " nodes)\n", n_helper_nodes);
+		if (get_numa_node_number() > 1) {
+			fprintf(f, "same numa node splits:%11" PRIu64 " (%6.2f%%)\n", statistics.n_split_local, 100.0 * statistics.n_split_local / (statistics.n_split_success - statistics.n_master_helper));
+			for (j = 0; j < get_numa_node_number(); ++j) {
+				uint64_t n_calls = 0, n_nodes = 0;
+				int n_tasks = 0;
+				for (i = 0; i < options.n_task; ++i) if (statistics.task_numa_node[i] == j) {
+					++n_tasks;
+					n_calls += statistics.n_task[i];
+					n_nodes += (i == 0 ? statistics.n_nodes : statistics.n_task_nodes[i]);
+				}
+				if (n_tasks) fprintf(f, "numa node %d: %d tasks called %" PRIu64 " times (%" PRIu64 " nodes, %5.2f%%)\n", j, n_tasks, n_calls, n_nodes, 100.0 * n_nodes / (statistics.n_nodes + statistics.n_parallel_nodes));
+			}
+		}
 		fprintf(f, "\n\n");
 	}
 
+	if (statistics.n_stop) {
+		const uint64_t n_stop = statistics.n_stop;
+		const int n = (n_stop < STATS_STOP_SAMPLES ? (int) n_stop : STATS_STOP_SAMPLES);
+		int64_t latency[STATS_STOP_SAMPLES];
+		memcpy(latency, statistics.stop_latency, n * sizeof (int64_t));
+		qsort(latency, n, sizeof (int64_t), latency_compare);
+		fprintf(f, "stop latency: p50 = %.3f ms, p99 = %.3f ms, max = %.3f ms (%" PRIu64 " stops)\n\n",
+			1e-6 * latency[n / 2], 1e-6 * latency[(n * 99) / 100], 1e-6 * latency[n - 1], n_stop);
+	}
 
 	if (statistics.n_PVS_root) {
 		fprintf(f, "Search:\n");
@@ -61,11 +61,15 @@
 	#define SEARCH_UPDATE_ALL_NODES(n)
 #endif
 
+/** number of stop latencies kept */
+#define STATS_STOP_SAMPLES 1024
+
 /** struct Statistics */
 typedef struct Statistics {
 	uint64_t n_nodes;
 	uint64_t n_task_nodes[MAX_THREADS];
 	uint64_t n_task[MAX_THREADS];
+	int task_numa_node[MAX_THREADS];
 	uint64_t n_parallel_nodes;
 
 	uint64_t n_hash_update;
@@ -99,11 +103,18 @@ typedef struct Statistics {
 
 	_Atomic uint64_t n_split_try;
 	_Atomic uint64_t n_split_success;
+	_Atomic uint64_t n_split_local;
 	_Atomic uint64_t n_master_helper;
 	_Atomic uint64_t n_waited_slave;
 	_Atomic uint64_t n_stopped_slave;
 	_Atomic uint64_t n_stopped_master;
 	_Atomic uint64_t n_wake_up;
+	_Atomic uint64_t n_clone;
+	_Atomic uint64_t clone_time;
+	_Atomic uint64_t n_node_lock;
+	_Atomic uint64_t node_lock_time;
+	_Atomic uint64_t n_stop;
+	int64_t stop_latency[STATS_STOP_SAMPLES];
 
 	uint64_t n_hash_try, n_hash_low_cutoff, n_hash_high_cutoff;
 	uint64_t n_stability_try, n_stability_low_cutoff;
@@ -125,6 +136,7 @@ struct Search;
 
 void statistics_init(void);
 void statistics_sum_nodes(struct Search*);
+void statistics_add_stop_latency(const int64_t);
 void statistics_print(FILE*);
 
 #endif
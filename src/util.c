@@ -35,6 +35,8 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 
 #endif // __unix__ || __APPLE__
 
@@ -112,6 +114,25 @@ int64_t real_clock(void)
 #endif
 }
 
+/**
+ * @brief nano_clock
+ *
+ * Measure wall clock time with a fine resolution, to time short events.
+ * @return time in nanoseconds.
+ */
+int64_t nano_clock(void)
+{
+#if _POSIX_TIMERS > 0
+	struct timespec tv;
+	clock_gettime(CLOCK_MONOTONIC, &tv);
+	return tv.tv_sec * 1000000000ULL + tv.tv_nsec;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000000LL + tv.tv_usec * 1000LL;
+#endif
+}
+
 /**
  * @brief cpu_clock
  *
@@ -145,6 +166,14 @@ int64_t real_clock(void)
 	return GetTickCount();
 }
 
+int64_t nano_clock(void)
+{
+	LARGE_INTEGER t, f;
+	QueryPerformanceCounter(&t);
+	QueryPerformanceFrequency(&f);
+	return (int64_t) (t.QuadPart * (1000000000.0 / f.QuadPart));
+}
+
 int64_t cpu_clock(void)
 {
 	return GetTickCount();
@@ -1141,6 +1170,114 @@ char* file_add_ext(const char *base, const char *ext, char *file)
 	return file;
 }
 
+/**
+ * @brief Write an integer in little-endian order.
+ *
+ * @param buffer Output bytes.
+ * @param x Integer.
+ * @param n Integer size in bytes.
+ */
+void put_le(unsigned char *buffer, uint64_t x, const int n)
+{
+	int i;
+
+	for (i = 0; i < n; ++i, x >>= 8) buffer[i] = (unsigned char) x;
+}
+
+/**
+ * @brief Read an integer in little-endian order.
+ *
+ * @param buffer Input bytes.
+ * @param n Integer size in bytes.
+ * @return the integer.
+ */
+uint64_t get_le(const unsigned char *buffer, const int n)
+{
+	uint64_t x = 0;
+	int i;
+
+	for (i = n - 1; i >= 0; --i) x = (x << 8) | buffer[i];
+	return x;
+}
+
+/**
+ * @brief Map a file into memory, for reading only.
+ *
+ * @param file File name.
+ * @param size Mapped size (output).
+ * @return The address of the file contents, or NULL on failure.
+ */
+void* file_map(const char *file, size_t *size)
+{
+	void *address = NULL;
+
+#if defined(__unix__) || defined(__APPLE__)
+	struct stat st;
+	int fd = open(file, O_RDONLY);
+
+	if (fd < 0) return NULL;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		address = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (address == MAP_FAILED) address = NULL;
+		else *size = st.st_size;
+	}
+	close(fd);
+
+#elif defined(_WIN32)
+	HANDLE h, m;
+	LARGE_INTEGER n;
+
+	h = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (h == INVALID_HANDLE_VALUE) return NULL;
+	if (GetFileSizeEx(h, &n) && n.QuadPart > 0) {
+		m = CreateFileMappingA(h, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m) {
+			address = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+			if (address) *size = (size_t) n.QuadPart;
+			CloseHandle(m);
+		}
+	}
+	CloseHandle(h);
+
+#else
+	FILE *f = fopen(file, "rb");
+	long n;
+
+	if (f == NULL) return NULL;
+	if (fseek(f, 0, SEEK_END) == 0 && (n = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0) {
+		address = malloc(n);
+		if (address && fread(address, 1, n, f) != (size_t) n) {
+			free(address);
+			address = NULL;
+		}
+		if (address) *size = n;
+	}
+	fclose(f);
+
+#endif
+
+	return address;
+}
+
+/**
+ * @brief Unmap a file mapped by file_map().
+ *
+ * @param address The address of the file contents.
+ * @param size Mapped size.
+ */
+void file_unmap(void *address, const size_t size)
+{
+	if (address == NULL) return;
+#if defined(__unix__) || defined(__APPLE__)
+	munmap(address, size);
+#elif defined(_WIN32)
+	(void) size;
+	UnmapViewOfFile(address);
+#else
+	(void) size;
+	free(address);
+#endif
+}
 
 /**
  * @brief Get the number of cpus or cores on the machine.
@@ -1194,6 +1331,193 @@ int get_cpu_number(void)
 	return n;
 }
 
+/** cpu topology */
+static struct {
+	int n_cpus;              /**< number of cpus */
+	int n_nodes;             /**< number of numa nodes */
+	int node[MAX_THREADS];   /**< numa node of each cpu */
+	int cpu[MAX_THREADS];    /**< cpus sorted by numa node */
+} topology;
+
+/**
+ * @brief Read the cpus of a numa node from a list like "0-7,16-23".
+ *
+ * @param list List of cpus.
+ * @param node Numa node.
+ */
+static void topology_parse_cpulist(const char *list, const int node)
+{
+	int first, last, cpu;
+	char *end;
+
+	while (*list) {
+		first = last = strtol(list, &end, 10);
+		if (end == list) break;
+		if (*end == '-') last = strtol(end + 1, &end, 10);
+		for (cpu = first; cpu <= last && cpu < MAX_THREADS; ++cpu) topology.node[cpu] = node;
+		list = end;
+		while (*list == ',' || isspace(*list)) ++list;
+	}
+}
+
+/**
+ * @brief Detect the cpu topology (numa node of each cpu).
+ *
+ * Without numa information, all the cpus belong to a single node.
+ */
+void cpu_topology_init(void)
+{
+	int cpu, node, i;
+
+	topology.n_cpus = MIN(get_cpu_number(), MAX_THREADS);
+	topology.n_nodes = 1;
+	for (cpu = 0; cpu < MAX_THREADS; ++cpu) topology.node[cpu] = 0;
+
+#if defined(__linux__)
+	{
+		char file[64], line[1024];
+		FILE *f;
+		int max_node = 0;
+
+		for (node = 0; node < 64; ++node) {
+			sprintf(file, "/sys/devices/system/node/node%d/cpulist", node);
+			if ((f = fopen(file, "r")) == NULL) {
+				if (errno == ENOENT) errno = 0; // nodes are not numbered up to 64: a missing one is expected
+				continue;
+			}
+			if (fgets(line, sizeof line, f)) topology_parse_cpulist(line, node);
+			fclose(f);
+			max_node = node;
+		}
+		topology.n_nodes = max_node + 1;
+	}
+#elif defined(_WIN32)
+	for (cpu = 0; cpu < topology.n_cpus; ++cpu) {
+		UCHAR n;
+		if (GetNumaProcessorNode(cpu, &n) && n < MAX_THREADS) topology.node[cpu] = n;
+		if (topology.node[cpu] >= topology.n_nodes) topology.n_nodes = topology.node[cpu] + 1;
+	}
+#endif
+
+	// sort the cpus by node, so that consecutive tasks share the same node.
+	for (i = 0, node = 0; node < topology.n_nodes; ++node) {
+		for (cpu = 0; cpu < topology.n_cpus; ++cpu) {
+			if (topology.node[cpu] == node) topology.cpu[i++] = cpu;
+		}
+	}
+	topology.n_cpus = i;
+}
+
+/**
+ * @brief Get the number of numa nodes.
+ * @return Numa node number.
+ */
+int get_numa_node_number(void)
+{
+	return topology.n_nodes;
+}
+
+/**
+ * @brief Get the numa node of a cpu.
+ * @param cpu Cpu.
+ * @return Numa node.
+ */
+int get_cpu_numa_node(const int cpu)
+{
+	return (0 <= cpu && cpu < MAX_THREADS) ? topology.node[cpu] : 0;
+}
+
+/**
+ * @brief Get the cpu to bind the i-th task to.
+ *
+ * Tasks fill the cpus of a numa node before using the cpus of the next node.
+ *
+ * @param i Task index.
+ * @return A cpu, or -1 if the topology is unknown.
+ */
+int get_task_cpu(const int i)
+{
+	return topology.n_cpus > 0 ? topology.cpu[i % topology.n_cpus] : -1;
+}
+
+/**
+ * @brief Bind the current thread to a cpu.
+ * @param cpu Cpu.
+ * @return true if the thread has been bound, false otherwise.
+ */
+bool thread_set_cpu(const int cpu)
+{
+#if defined(__linux__) && !defined(ANDROID)
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof set, &set) == 0;
+#elif defined(_WIN32)
+	return SetThreadAffinityMask(GetCurrentThread(), 1ull << cpu) != 0;
+#else
+	(void) cpu;
+	return false;
+#endif
+}
+
+/**
+ * @brief Get the cpus the current thread may run on.
+ * @param cpus Set of cpus (output).
+ * @return true if the set of cpus is known, false otherwise.
+ */
+bool thread_get_cpus(CpuSet *cpus)
+{
+#if defined(__linux__) && !defined(ANDROID)
+	cpu_set_t set;
+	int cpu;
+
+	if (sched_getaffinity(0, sizeof set, &set) != 0) return false;
+	memset(cpus, 0, sizeof *cpus);
+	for (cpu = 0; cpu < 256 && cpu < CPU_SETSIZE; ++cpu) {
+		if (CPU_ISSET(cpu, &set)) cpus->mask[cpu >> 6] |= 1ull << (cpu & 63);
+	}
+	return true;
+#elif defined(_WIN32)
+	DWORD_PTR process, system, mask;
+
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) return false;
+	mask = SetThreadAffinityMask(GetCurrentThread(), process);
+	if (mask == 0) return false;
+	SetThreadAffinityMask(GetCurrentThread(), mask);
+	memset(cpus, 0, sizeof *cpus);
+	cpus->mask[0] = mask;
+	return true;
+#else
+	(void) cpus;
+	return false;
+#endif
+}
+
+/**
+ * @brief Let the current thread run on a set of cpus.
+ * @param cpus Set of cpus.
+ * @return true if the thread has been bound, false otherwise.
+ */
+bool thread_set_cpus(const CpuSet *cpus)
+{
+#if defined(__linux__) && !defined(ANDROID)
+	cpu_set_t set;
+	int cpu;
+
+	CPU_ZERO(&set);
+	for (cpu = 0; cpu < 256 && cpu < CPU_SETSIZE; ++cpu) {
+		if ((cpus->mask[cpu >> 6] >> (cpu & 63)) & 1) CPU_SET(cpu, &set);
+	}
+	return sched_setaffinity(0, sizeof set, &set) == 0;
+#elif defined(_WIN32)
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) cpus->mask[0]) != 0;
+#else
+	(void) cpus;
+	return false;
+#endif
+}
+
 /**
  * @brief Pseudo-random number generator.
  *
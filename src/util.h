@@ -47,6 +47,7 @@ void* aligned_alloc(size_t, size_t);
  * Time management
  */
 int64_t real_clock(void);
+int64_t nano_clock(void);
 int64_t cpu_clock(void);
 void time_print(int64_t, bool, FILE*);
 int64_t time_read(FILE*);
@@ -149,6 +150,10 @@ char* parse_skip_word(const char*);
  */
 void path_get_dir(const char*, char*);
 char* file_add_ext(const char*, const char*, char*);
+void* file_map(const char*, size_t*);
+void file_unmap(void*, const size_t);
+void put_le(unsigned char*, uint64_t, const int);
+uint64_t get_le(const unsigned char*, const int);
 bool is_stdin_keyboard(void);
 
 /*
@@ -184,6 +189,19 @@ void random_seed(Random*, const uint64_t);
 
 void cpu(void);
 int get_cpu_number(void);
+void cpu_topology_init(void);
+int get_numa_node_number(void);
+int get_cpu_numa_node(const int);
+int get_task_cpu(const int);
+
+/** Set of cpus a thread may run on */
+typedef struct CpuSet {
+	uint64_t mask[4];        /**< one bit per cpu, up to 256 cpus */
+} CpuSet;
+
+bool thread_set_cpu(const int);
+bool thread_get_cpus(CpuSet*);
+bool thread_set_cpus(const CpuSet*);
 
 /**
  * @brief LogFile.
@@ -322,7 +322,7 @@ void xboard_stop_analyzing(Play *play)
 	while (play->state == IS_ANALYZING) {
 		log_print(&xboard_log, "edax (analyze)> stop\n");
 		search_stop_all(&play->search, STOP_PONDERING);
-		relax(10);
+		relax(1);
 	}
 
 	if (play->ponder.launched) {
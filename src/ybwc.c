@@ -46,6 +46,66 @@
 
 extern Log search_log;
 
+/**
+ * @brief Pack a score and a move into a single value.
+ *
+ * The packed values are ordered as their scores, so that the best score and
+ * its move can be updated together with a single compare & swap.
+ *
+ * @param score Score.
+ * @param x Move.
+ * @return The packed score & move.
+ */
+static inline int best_pack(const int score, const int x)
+{
+	return ((score + SCORE_INF) << 8) | x;
+}
+
+/**
+ * @brief Get the score of a packed score & move.
+ *
+ * @param best Packed score & move.
+ * @return The score.
+ */
+static inline int best_score(const int best)
+{
+	return (best >> 8) - SCORE_INF;
+}
+
+/**
+ * @brief Get the move of a packed score & move.
+ *
+ * @param best Packed score & move.
+ * @return The move.
+ */
+static inline int best_move(const int best)
+{
+	return best & 0xff;
+}
+
+/**
+ * @brief Lock a node.
+ *
+ * @param node Node.
+ */
+static void node_lock(Node *node)
+{
+	mtx_lock(&node->mutex);
+	YBWC_STATS(node->lock_time = nano_clock();)
+}
+
+/**
+ * @brief Unlock a node.
+ *
+ * @param node Node.
+ */
+static void node_unlock(Node *node)
+{
+	YBWC_STATS(atomic_fetch_add(&statistics.n_node_lock, 1);)
+	YBWC_STATS(atomic_fetch_add(&statistics.node_lock_time, nano_clock() - node->lock_time);)
+	mtx_unlock(&node->mutex);
+}
+
 /**
  * @brief Initialize a node
  *
@@ -73,20 +133,23 @@ void node_init(Node* node, Search *search, const int alpha, const int beta, cons
 	mtx_init(&node->mutex, mtx_plain);
 	cnd_init(&node->condition);
 
-	node->alpha = alpha;
+	atomic_init(&node->alpha, alpha);
+	atomic_init(&node->best, best_pack(-SCORE_INF, NOMOVE));
+	atomic_init(&node->i_move, 0);
 	node->beta = beta;
 	node->depth = depth;
 	node->height = search->height;
-	node->move = NULL;
+	node->move[0] = NULL;
 	node->pv_node = false;
+	node->multipv = false;
 	node->bestmove = NOMOVE;
 	node->bestscore = -SCORE_INF;
-	node->n_moves_todo = n_moves;
-	node->n_moves_done = 0;
+	node->n_moves = n_moves;
 	node->parent = parent;
 	node->search = search;
 	for (i = 0; i < SPLIT_MAX_SLAVES; ++i) node->slave[i] = NULL;
 	node->n_slave = 0;
+	node->n_split = 0;
 	node->is_waiting = false;
 	node->is_helping = false;
 	node->stop_point = false;
@@ -121,23 +184,25 @@ static bool get_helper(Node *master, Node *node, Move *move)
 
 	if (master) {
 		if (master->is_waiting && !master->is_helping) {
-			mtx_lock(&master->mutex);
+			node_lock(master);
 			if (master->n_slave && master->is_waiting && !master->is_helping) {
 				master->is_helping = true;
 				task = &master->help;
 				task_init(task) ;
+				task->numa_node = master->search->task->numa_node;
 				task->node = node;
 				task->move = move;
 				search_clone(task->search, node->search);
-				mtx_lock(&node->mutex);
+				node_lock(node);
 					node->slave[node->n_slave++] = task->search;
-				mtx_unlock(&node->mutex);
+					++node->n_split;
+				node_unlock(node);
 				task->run = true;
 				found = true;
 
 				cnd_broadcast(&master->condition);
 			}
-			mtx_unlock(&master->mutex);
+			node_unlock(master);
 		} else {
 			found = get_helper(master->parent, node, move);
 		}
@@ -172,25 +237,28 @@ bool node_split(Node *node, Move *move)
 {
 	Task *task;
 	Search *search = node->search;
+	const int i_move = atomic_load_explicit(&node->i_move, memory_order_relaxed);
 
 	if (search->allow_node_splitting // split only if parallelism is on
 	 && node->depth >= SPLIT_MIN_DEPTH // split if we are deep enough
-	 && node->n_moves_done // do not split first move (ybwc main principle).
+	 && i_move > 0 // do not split first move (ybwc main principle).
 	 && node->n_slave < SPLIT_MAX_SLAVES // do not split too much at the same point.
-	 && node->n_moves_todo >=  SPLIT_MIN_MOVES_TODO) {  // do not split the last move(s), to diminish waiting time
+	 && node->n_moves - i_move >=  SPLIT_MIN_MOVES_TODO) {  // do not split the last move(s), to diminish waiting time
 		YBWC_STATS(atomic_fetch_add(&statistics.n_split_try, 1);)
 
 		if (get_helper(node->parent, node, move)) {
 			YBWC_STATS(atomic_fetch_add(&statistics.n_master_helper, 1);)
 			return true;
-		} else if ((task = task_stack_get_idle_task(search->tasks)) != NULL) {
+		} else if ((task = task_stack_get_idle_task(search->tasks, search->task->numa_node)) != NULL) {
 			task->node = node;
 			task->move = move;
 			search_clone(task->search, search);
-			mtx_lock(&node->mutex);
+			node_lock(node);
 				node->slave[node->n_slave++] = task->search;
-			mtx_unlock(&node->mutex);
+				++node->n_split;
+			node_unlock(node);
 			YBWC_STATS(atomic_fetch_add(&statistics.n_split_success, 1);)
+			YBWC_STATS(if (task->numa_node == search->task->numa_node) atomic_fetch_add(&statistics.n_split_local, 1);)
 
 			mtx_lock(&task->mutex);
 				task->run = true;
@@ -203,27 +271,44 @@ bool node_split(Node *node, Move *move)
 	return false;
 }
 
+/**
+ * @brief Stop the slaves of a node.
+ *
+ * The node should be locked.
+ *
+ * @param node Node.
+ */
+void node_stop_slaves(Node *node)
+{
+	int i;
+
+	for (i = 0; i < node->n_slave; ++i) {
+		search_stop_all(node->slave[i], STOP_PARALLEL_SEARCH);
+		YBWC_STATS(atomic_fetch_add(&statistics.n_stopped_slave, 1);)
+	}
+}
+
 /**
  * @brief Wait for slaves termination.
  *
- * Actually, three steps are performed here:
+ * If the node has been splitted, four steps are performed here:
  *   -# Stop slaves node in case their scores are unneeded.
  *   -# Wait for slaves' termination.
  *   -# Wake-up the master thread that may have been stopped.
+ *   -# Copy the shared bestscore & bestmove into the node.
  *
  * @param node Node.
  */
 void node_wait_slaves(Node* node)
 {
-	int i;
+	int best;
 
-	mtx_lock(&node->mutex);
+	if (node->n_split == 0) return; // no slave: the node was searched sequentially.
+
+	node_lock(node);
 	// stop slaves ?
 	if ((node->alpha >= node->beta || node->search->stop) && node->n_slave) {
-		for (i = 0; i < node->n_slave; ++i) {
-			search_stop_all(node->slave[i], STOP_PARALLEL_SEARCH);
-			YBWC_STATS(atomic_fetch_add(&statistics.n_stopped_slave, 1);)
-		}
+		node_stop_slaves(node);
 	}
 
 	// wait slaves
@@ -231,12 +316,16 @@ void node_wait_slaves(Node* node)
 	while (node->n_slave) {
 		node->is_waiting = true;
 		assert(node->is_helping == false);
+		YBWC_STATS(atomic_fetch_add(&statistics.node_lock_time, nano_clock() - node->lock_time);) // do not count the sleeping time
 		cnd_wait(&node->condition, &node->mutex);
+		YBWC_STATS(node->lock_time = nano_clock();)
 
-		if (node->is_helping) {
+		if (node->is_helping) { // help without holding the lock, so that the slaves can go on.
 			assert(node->help.run);
-			task_search(&node->help);
-			task_free(&node->help);
+			node_unlock(node);
+				task_search(&node->help);
+				task_free(&node->help);
+			node_lock(node);
 			node->is_helping = false;
 		} else {
 			node->is_waiting = false;
@@ -249,15 +338,47 @@ void node_wait_slaves(Node* node)
 		node->stop_point = false;
 		YBWC_STATS(atomic_fetch_add(&statistics.n_wake_up, 1);)
 	}
-	mtx_unlock(&node->mutex);
+	node_unlock(node);
+
+	best = atomic_load(&node->best);
+	if (best_score(best) > node->bestscore) {
+		node->bestscore = best_score(best);
+		node->bestmove = best_move(best);
+	}
 }
 
+/**
+ * @brief Raise the best score of a node.
+ *
+ * The bestscore, bestmove & alpha are updated with a compare & swap loop, so that
+ * concurrent updates never need a lock.
+ *
+ * @param node Node.
+ * @param move Evaluated move.
+ * @return true if the move is the best one found so far.
+ */
+static bool node_raise(Node *node, const Move *move)
+{
+	const int score = move->score;
+	const int best = best_pack(score, move->x);
+	int old = atomic_load_explicit(&node->best, memory_order_relaxed);
+
+	while (score > best_score(old)) {
+		if (atomic_compare_exchange_weak(&node->best, &old, best)) {
+			old = atomic_load_explicit(&node->alpha, memory_order_relaxed);
+			while (score > old && !atomic_compare_exchange_weak(&node->alpha, &old, score)) ;
+			return true;
+		}
+	}
+	return false;
+}
 
 /**
  * @brief Update a node.
  *
  * Update bestmove, bestscore and alpha value of the node, in case the move is the bestmove found so far.
- * The function is thread-safe although it updates a shared resource. Double check lock is used as an optimization.
+ * The function is thread-safe although it updates a shared resource. The update
+ * is lock-free, except at the root, where the best moves are recorded in order.
  *
  * @param node current node.
  * @param move last evaluated move.
@@ -265,34 +386,35 @@ void node_wait_slaves(Node* node)
 void node_update(Node* node, Move *move)
 {
 	Search *search = node->search;
-	const int score = move->score;
-	int i;
 
-	mtx_lock(&node->mutex);
-	if (!search->stop && score > node->bestscore) {
-		node->bestscore = score;
-		node->bestmove = move->x;
-		if (node->height == 0) {
+	if (node->height == 0) {
+		node_lock(node);
+		if (node->multipv && !search->stop) record_move_score(search, move, SCORE_MIN, node->beta);
+		if (!search->stop && node_raise(node, move)) {
+			node->bestscore = move->score;
+			node->bestmove = move->x;
 			record_best_move(search, &search->board, move, node->alpha, node->beta, node->depth);
 			search->result->n_moves_left--;
 		}
-		if (score > node->alpha) node->alpha = score;
+		node_unlock(node);
+	} else if (!search->stop && node_raise(node, move)) {
+		node->bestscore = move->score;
+		node->bestmove = move->x;
 	}
-	if (node->alpha >= node->beta  && node->n_slave) { // stop slave ?
-		for (i = 0; i < node->n_slave; ++i) {
-			search_stop_all(node->slave[i], STOP_PARALLEL_SEARCH);
-			YBWC_STATS(atomic_fetch_add(&statistics.n_stopped_slave, 1);)
-		}
+
+	if (node->alpha >= node->beta && node->n_slave) { // stop slave ?
+		node_lock(node);
+			node_stop_slaves(node);
+		node_unlock(node);
 	}
-	mtx_unlock(&node->mutex);
 }
 
 /**
  * @brief Get the first move of the move list.
  *
- * This is thread/safe getter of the first move. If the search is stopped,
- * or an alphabeta cut has been found or no move is available the function
- * returns NULL.
+ * This getter of the first move also sets up the moves to hand out to the
+ * other threads. If the search is stopped, or an alphabeta cut has been found
+ * or no move is available the function returns NULL.
  *
  * @param node Node data.
  * @param movelist List of moves.
@@ -301,59 +423,42 @@ void node_update(Node* node, Move *move)
 Move* node_first_move(Node *node, MoveList *movelist)
 {
 	Move *move;
-	mtx_lock(&node->mutex);
-		node->n_moves_todo = movelist->n_moves;
-		node->n_moves_done = 0;
-		node->move = movelist_first(movelist);
-		if (node->move && !node->search->stop) {
-			assert(node->alpha < node->beta);
-			move = node->move;
-		} else {
-			move = NULL;
-		}
-	mtx_unlock(&node->mutex);
-	return move;
-}
+	int n = 0;
 
-/**
- * @brief Get the next move of the move list.
- *
- * This is a thread/safe getter of the next move. If the search is stopped,
- * or an alphabeta cut has been found or no move is available the function
- * returns NULL.
- *
- * @param node Node data.
- * @return the next move of the list or NULL if none is available.
- */
-static Move* node_next_move_lockless(Node *node)
-{
-	Move *move;
-	if (node->move && node->alpha < node->beta && !node->search->stop) {
-		++node->n_moves_done; --node->n_moves_todo;
-		move = node->move = move_next(node->move);
+	foreach_move (move, movelist) node->move[n++] = move;
+	node->move[n] = NULL;
+	node->n_moves = n;
+	atomic_store_explicit(&node->i_move, 0, memory_order_relaxed);
+
+	if (node->move[0] && !node->search->stop) {
+		assert(node->alpha < node->beta);
+		move = node->move[0];
 	} else {
 		move = NULL;
 	}
-
 	return move;
 }
 
 /**
  * @brief Get the next move of the move list.
  *
- * This is a thread/safe getter of the next move.
+ * This is a thread/safe & lock-free getter of the next move. If the search is stopped,
+ * or an alphabeta cut has been found or no move is available the function
+ * returns NULL.
  *
  * @param node Node data.
  * @return the next move of the list.
  */
 Move* node_next_move(Node *node)
 {
-	Move *move;
-	mtx_lock(&node->mutex);
-		move = node_next_move_lockless(node);
-	mtx_unlock(&node->mutex);
+	int i;
 
-	return move;
+	if (node->alpha < node->beta && !node->search->stop) {
+		i = atomic_fetch_add_explicit(&node->i_move, 1, memory_order_relaxed) + 1;
+		if (i < node->n_moves) return node->move[i];
+	}
+
+	return NULL;
 }
 
 /**
@@ -376,8 +481,8 @@ void task_search(Task *task)
 	YBWC_STATS(++task->n_calls;)
 
 	while (move && !search->stop) {
-		const int alpha = node->alpha;
-		if (alpha >= node->beta) break;
+		const int alpha = node->multipv ? SCORE_MIN : node->alpha;
+		if (node->alpha >= node->beta) break;
 
 		search_update_midgame(search, move);
 			move->score = -NWS_midgame(search, -alpha - 1, node->depth - 1, node);
@@ -396,26 +501,33 @@ void task_search(Task *task)
 			}
 		}
 
-		mtx_lock(&node->mutex);
-		if (!search->stop && move->score > node->bestscore) {
-			node->bestscore = move->score;
-			node->bestmove = move->x;
+		if (!search->stop) {
+			bool has_raised;
 			if (node->height == 0) {
-				record_best_move(search, &search->board, move, alpha, node->beta, node->depth);
-				search->result->n_moves_left--;
-				if (search->options.verbosity == 4) pv_debug(search, move, stdout);
+				node_lock(node);
+				if (node->multipv) record_move_score(search, move, alpha, node->beta);
+				if ((has_raised = node_raise(node, move))) {
+					node->bestscore = move->score;
+					node->bestmove = move->x;
+					record_best_move(search, &search->board, move, alpha, node->beta, node->depth);
+					search->result->n_moves_left--;
+					if (search->options.verbosity == 4) pv_debug(search, move, stdout);
+				}
+				node_unlock(node);
+			} else {
+				has_raised = node_raise(node, move);
 			}
-			if (node->bestscore > node->alpha) {
-				node->alpha = node->bestscore;
-				if (node->alpha >= node->beta && node->search->stop == RUNNING) { // stop the master thread?
+			if (has_raised && node->alpha >= node->beta && node->search->stop == RUNNING) { // stop the master thread?
+				node_lock(node);
+				if (node->search->stop == RUNNING) {
 					node->stop_point = true;
 					node->search->stop = STOP_PARALLEL_SEARCH;
 					YBWC_STATS(atomic_fetch_add(&statistics.n_stopped_master, 1);)
 				}
+				node_unlock(node);
 			}
 		}
-		move = node_next_move_lockless(node);
-		mtx_unlock(&node->mutex);
+		move = node_next_move(node);
 	}
 
 	search_set_state(search, STOP_END);
@@ -432,7 +544,7 @@ void task_search(Task *task)
 		YBWC_STATS(task->n_nodes += search->n_nodes;)
 	spinlock_unlock(&search->parent->spin);
 
-	mtx_lock(&node->mutex);
+	node_lock(node);
 		task->run = false;
 		for (i = 0; i < node->n_slave; ++i) {
 			if (node->slave[i] == search) {
@@ -442,7 +554,7 @@ void task_search(Task *task)
 			}
 		}
 		cnd_broadcast(&node->condition);
-	mtx_unlock(&node->mutex);
+	node_unlock(node);
 }
 
 
@@ -462,6 +574,8 @@ int task_loop(void *param)
 {
 	Task *task = (Task*) param;
 
+	if (task->cpu >= 0) thread_set_cpu(task->cpu);
+
 	mtx_lock(&task->mutex);
 	task->loop = true;
 
@@ -535,6 +649,8 @@ void task_init(Task *task)
 	task->move = NULL;
 	task->n_calls = 0;
 	task->n_nodes = 0;
+	task->cpu = -1;
+	task->numa_node = 0;
 	task->search = task_search_create(task);
 }
 
@@ -563,8 +679,9 @@ void task_free(Task *task)
  *
  * @param stack The stack of tasks.
  * @param n Stack size (number of tasks).
+ * @param first_cpu Index of the cpu of the first task.
  */
-void task_stack_init(TaskStack *stack, const int n)
+void task_stack_init(TaskStack *stack, const int n, const int first_cpu)
 {
 	int i;
 
@@ -572,6 +689,7 @@ void task_stack_init(TaskStack *stack, const int n)
 
 	stack->n = n; // number of additional task
 	stack->n_idle = 0;
+	stack->first_cpu = first_cpu;
 
 	if (stack->n) {
 		// allocate the tasks
@@ -584,15 +702,19 @@ void task_stack_init(TaskStack *stack, const int n)
 			fatal_error("Cannot allocate a stack of %d entries\n", stack->n);
 		}
 
-		// init the tasks.
+		// init the tasks, bound to cpus sorted by numa node if requested.
 		for (i = 0; i < stack->n; ++i) {
-			if (i) {
-				task_init(stack->task + i);
-				thrd_create(&stack->task[i].thread, task_loop, stack->task + i);
-			}
-			stack->task[i].container = stack;
+			Task *task = stack->task + i;
+			if (i) task_init(task);
+			task->cpu = options.cpu_affinity ? get_task_cpu(first_cpu + i) : -1;
+			task->numa_node = get_cpu_numa_node(task->cpu);
+			if (i) thrd_create(&task->thread, task_loop, task);
+			task->container = stack;
 			stack->stack[i] = NULL;
 		}
+		if (options.cpu_affinity) {
+			info("<%d tasks bound to cpus over %d numa node(s)>\n", stack->n, get_numa_node_number());
+		}
 
 		// put the tasks onto stack;
 		for (i = 1; i < stack->n; ++i) {
@@ -631,24 +753,34 @@ void task_stack_free(TaskStack *stack)
  */
 void task_stack_resize(TaskStack *stack, const int n)
 {
+	const int first_cpu = stack->first_cpu;
+
 	task_stack_free(stack);
-	task_stack_init(stack, n);
+	task_stack_init(stack, n, first_cpu);
 }
 
 /**
  * @brief Return, if available, an idle task.
  *
+ * An idle task running on the given numa node is preferred, so that the
+ * helper shares the memory node of the split position.
+ *
  * @param stack The stack of tasks.
+ * @param numa_node Preferred numa node.
  * @return An idle task.
  */
-Task* task_stack_get_idle_task(TaskStack *stack)
+Task* task_stack_get_idle_task(TaskStack *stack, const int numa_node)
 {
 	Task *task;
+	int i;
 
 	mtx_lock(&stack->mutex);
 
 	if (stack->n_idle) {
-		task = stack->stack[--stack->n_idle];
+		for (i = stack->n_idle - 1; i >= 0 && stack->stack[i]->numa_node != numa_node; --i) ;
+		if (i < 0) i = stack->n_idle - 1;
+		task = stack->stack[i];
+		stack->stack[i] = stack->stack[--stack->n_idle];
 	} else {
 		task = NULL;
 	}
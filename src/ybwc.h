@@ -34,6 +34,8 @@ typedef struct Task {
 	struct TaskStack *container; /**< link to its container */
 	uint64_t n_calls;            /**< call counter */
 	uint64_t n_nodes;            /**< nodes counter */
+	int cpu;                     /**< cpu the task is bound to (-1 if unbound) */
+	int numa_node;               /**< numa node the task runs on */
 	thrd_t thread;               /**< thread */
 	mtx_t mutex;                 /**< mutex (thread lock) */
 	cnd_t condition;             /**< condition variable */
@@ -44,26 +46,35 @@ typedef struct Task {
 /**
  * A Node is a position in the search tree, containing information shared with
  * parallel threads.
+ *
+ * Moves are handed out through an atomic index into the move array, and the
+ * alpha bound and best score are raised with atomic compare & swap, so that
+ * the threads searching a node do not serialise on its mutex. The mutex and the
+ * condition variable are only used to sleep and to manage the list of slaves.
  */
 typedef struct Node {
 	struct Search *search;                  /**< master search structure */
 	struct Search *slave[SPLIT_MAX_SLAVES]; /**< slave search structure */
 	struct Node *parent;                    /**< master node */
-	struct Move *move;                      /**< move to search */
+	struct Move *move[MAX_MOVE + 1];        /**< moves to search */
 	Task help;          /**< helper task */
 	mtx_t mutex;        /**< mutex */
 	cnd_t condition;    /**< condition variable */
+	int64_t lock_time;  /**< time the mutex was locked at (statistics) */
+	_Atomic int best;   /**< packed bestscore & bestmove (shared) */
+	_Atomic int alpha;  /**< alpha lower bound */
+	_Atomic int i_move; /**< index of the last move handed out */
 	int bestmove;       /**< bestmove */
 	int bestscore;      /**< bestscore */
-	int alpha;          /**< alpha lower bound */
 	int beta;           /**< beta upper bound (is constant after initialisation) */
 	int n_slave;	    /**< number of slaves splitted flag */
+	int n_split;        /**< number of splits (set by the master thread only) */
 	int depth;          /**< depth */
 	int height;         /**< height */
-	int n_moves_done;   /**< search done */
-	int n_moves_todo;   /**< search todo */
+	int n_moves;        /**< number of moves */
 	bool is_helping;    /**< waiting flag */
 	bool pv_node;       /**< pv_node */
+	bool multipv;       /**< multi PV node: every move is searched with an open window */
 	bool stop_point;    /**< stop point flag */
 	bool is_waiting;	/**< waiting flag */
 } Node;
@@ -96,14 +107,15 @@ typedef struct TaskStack {
 	mtx_t mutex;                 /**< mutex */
 	int n;                       /**< maximal number of idle tasks */
 	int n_idle;                  /**< number of idle tasks */
+	int first_cpu;               /**< index of the cpu of the first task */
 } TaskStack;
 
 /* task stack function declaration */
-void task_stack_init(TaskStack*, const int);
+void task_stack_init(TaskStack*, const int, const int);
 void task_stack_free(TaskStack*);
 void task_stack_resize(TaskStack*, const int);
 void task_stack_stop(TaskStack*, const Stop);
-Task* task_stack_get_idle_task(TaskStack*);
+Task* task_stack_get_idle_task(TaskStack*, const int);
 void task_stack_put_idle_task(TaskStack*, Task*);
 void task_stack_clear(TaskStack*);
 uint64_t task_stack_count_nodes(TaskStack*);